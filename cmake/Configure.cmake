@@ -6,6 +6,9 @@
 if(cmake_build_type_tolower STREQUAL "debug")
   set(DEBUG_BUILD 1)
 endif()
+if(ENABLE_ALLOC_COUNTER)
+  set(COUNT_ALLOCATIONS 1)
+endif()
 set(PACKAGE_NAME ${PROJECT_NAME})
 set(PACKAGE_DESCRIPTION ${PROJECT_DESCRIPTION})
 set(PACKAGE_TARNAME ${PROJECT_NAME})
@@ -2,5 +2,10 @@ if(ENABLE_DOCTESTS)
     add_definitions(-DENABLE_DOCTEST_IN_LIBRARY)
 endif()
 
+# Installed by vcpkg (see pmm in CMakeLists.txt). Its header lives in a
+# doctest/ subdirectory; tests include it as "doctest.h".
+find_package(doctest CONFIG REQUIRED)
+find_path(DOCTEST_INCLUDE_DIR doctest.h PATH_SUFFIXES doctest)
 add_library(doctest INTERFACE)
-target_include_directories(doctest INTERFACE ${PROJECT_SOURCE_DIR}/external/doctest/doctest)
+target_link_libraries(doctest INTERFACE doctest::doctest)
+target_include_directories(doctest INTERFACE ${DOCTEST_INCLUDE_DIR})
@@ -0,0 +1,62 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <memory_resource>
+#include <stddef.h>
+
+/// Memory resource forwarding to `upstream` while counting allocations
+class counting_resource : public std::pmr::memory_resource
+{
+  public:
+    explicit counting_resource(
+        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : upstream_(upstream)
+    {
+    }
+
+    size_t allocations() const { return allocations_; }
+    size_t bytes() const { return bytes_; }
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    std::pmr::memory_resource* upstream_;
+    size_t allocations_ = 0;
+    size_t bytes_ = 0;
+};
+
+/// Per-invocation arena for the parse and format pipeline.
+/// Grabs one block sized for the input up front and hands out memory
+/// monotonically; everything is released at once when the arena is destroyed.
+/// Any further trip to the upstream allocator is counted, so a properly sized
+/// arena can be checked to make no malloc calls after construction.
+class arena
+{
+  public:
+    explicit arena(size_t initial_size);
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &pool_; }
+
+    /// Upstream allocations made after the initial block
+    size_t overflow_allocations() const { return counter_.allocations() - 1; }
+
+    /// Total bytes requested from upstream
+    size_t reserved_bytes() const { return counter_.bytes(); }
+
+  private:
+    counting_resource counter_;
+    std::pmr::monotonic_buffer_resource pool_;
+};
+
+/// Estimate arena size needed to parse and format a file of `bytes` bytes in
+/// `lines` lines, with ids. Short lines cost more per byte than long ones, so
+/// both are needed.
+size_t arena_size_for(size_t bytes, size_t lines);
+
+/// Number of global operator new calls made so far by the calling thread.
+/// Always 0 unless built with `-DENABLE_ALLOC_COUNTER=ON`.
+size_t global_allocations();
+#endif // ARENA_H
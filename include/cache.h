@@ -0,0 +1,89 @@
+#ifndef CACHE_H
+#define CACHE_H
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stddef.h>
+#include <string_view>
+#include <vector>
+
+/// Identity of a file's contents as far as caches are concerned
+struct file_stamp
+{
+    uint64_t size;
+    int64_t mtime_ns;
+    uint64_t inode;
+
+    /// Stamp of the file at `fpath`; all zero if it cannot be stat'ed
+    static file_stamp of(const std::filesystem::path& fpath);
+
+    /// Stamp of the open file `fd`; all zero if it cannot be stat'ed
+    static file_stamp of(int fd);
+
+    bool operator==(const file_stamp& other) const
+    {
+        return size == other.size && mtime_ns == other.mtime_ns && inode == other.inode;
+    }
+    bool operator!=(const file_stamp& other) const { return !(*this == other); }
+};
+
+/// Path of the `kind` sidecar kept next to `fpath` (e.g. `.todo.txt.lock`)
+std::filesystem::path sidecar_path(const std::filesystem::path& fpath, std::string_view kind);
+
+/// Path of the `kind` cache of `fpath` (e.g. `todo.txt-<hash>.trigram`), under
+/// `$XDG_CACHE_HOME/ctodo` or `~/.cache/ctodo`. Derived data stays out of the
+/// todo directory, which is often synced; the name hashes the absolute path of
+/// `fpath` so different todo files do not share caches.
+std::filesystem::path cache_path(const std::filesystem::path& fpath, std::string_view kind);
+
+/// Path of the `kind` state of `fpath` (e.g. `todo.txt-<hash>.base`), named as by
+/// `cache_path` but under `$XDG_STATE_HOME/ctodo` or `~/.local/state/ctodo`. For
+/// data that is not derived from the file and must not sync to other machines.
+std::filesystem::path state_path(const std::filesystem::path& fpath, std::string_view kind);
+
+/// Read-only memory mapping of a cache.
+/// Blobs are views into the mapping and stay valid while the object lives.
+class cache_file
+{
+  public:
+    ~cache_file();
+    cache_file(const cache_file&) = delete;
+    cache_file& operator=(const cache_file&) = delete;
+
+    /// Map cache at `path` if it was written for a file with `stamp`, else `nullptr`
+    static std::shared_ptr<cache_file> open(const std::filesystem::path& path,
+                                            const file_stamp& stamp);
+
+    size_t size() const { return blobs_.size(); }
+    std::string_view blob(size_t i) const { return blobs_[i]; }
+
+  private:
+    cache_file() = default;
+    void* map_ = nullptr;
+    size_t length_ = 0;
+    std::vector<std::string_view> blobs_;
+};
+
+/// Replace the file at `path` with the concatenation of `pieces`.
+/// Written to a temporary file in the same directory, then renamed over
+/// `path`, so readers see either the old or the new contents. The file keeps
+/// its permissions, and if `path` is a symlink, its target is replaced instead.
+/// @param `sync` Flush the contents to disk before the rename, so a crash
+/// cannot leave an empty file; caches that are rebuilt on demand skip it
+/// @return bool Whether the file was written
+bool write_file_atomic(const std::filesystem::path& path,
+                       const std::vector<std::string_view>& pieces, bool sync = true);
+
+/// Atomically write a cache of `blobs` tied to `stamp`, creating its directory.
+/// Failures (e.g. read-only directory) are not errors; the cache is just skipped.
+/// @return bool Whether the cache was written
+bool save_cache(const std::filesystem::path& path, const file_stamp& stamp,
+                const std::vector<std::string_view>& blobs);
+
+/// View an array of trivially copyable values as a blob
+template <typename T>
+std::string_view as_blob(const std::vector<T>& vec)
+{
+    return std::string_view(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+}
+#endif // CACHE_H
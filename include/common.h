@@ -1,20 +1,31 @@
+#ifndef COMMON_H
+#define COMMON_H
+#include "dedupe.h"
+#include "width.h"
 #include <fmt/format.h>
 #include <iostream>
 #include <memory>
 #include <stddef.h>
 #include <string>
+#include <string_view>
 #include <vector>
 
 /// @brief Data structure to hold common program options
 struct options
 {
     std::string cmd, verbosity;
+    std::vector<std::string> args; // positional arguments following `cmd`
     bool quiet, getline;
+    bool ids;               // prefix tasks with their stable id
+    overflow_mode overflow; // wrap or truncate lines wider than the terminal
+    size_t limit = 20;      // results shown per query by `pick`
+    dupe_mode dupes;        // what `add` does with a task already listed
 };
 
 std::ostream& operator<<(std::ostream&, std::shared_ptr<options>);
 
-/// Data structure for terminal cols and lines
+/// Data structure for terminal cols and lines.
+/// `cols` falls back to $COLUMNS, then 0, when no terminal is attached.
 struct termsize
 {
     unsigned cols, lines;
@@ -79,3 +90,4 @@ namespace Ansi {
     const std::string setBg(Ansi::Color);
     const std::string reset();
 } // namespace Ansi
+#endif // COMMON_H
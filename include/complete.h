@@ -0,0 +1,49 @@
+#ifndef COMPLETE_H
+#define COMPLETE_H
+#include "cache.h"
+#include "intern.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Completion index of tags (`@context`, `+project`, `key:`).
+/// Tags are kept sorted in one text blob, so the tags sharing a prefix are a
+/// contiguous range found by binary search; that range is then ranked by how
+/// many tasks carry each tag.
+class tag_index
+{
+  public:
+    /// Index every tag of `tags`
+    /// @param `counts` Tasks carrying each tag, by id
+    void build(const intern_table& tags, const std::vector<uint32_t>& counts);
+
+    /// Map a cache written for a file with `stamp`
+    bool load(const std::filesystem::path& path, const file_stamp& stamp);
+
+    /// Persist to `path`, tied to `stamp`
+    bool save(const std::filesystem::path& path, const file_stamp& stamp) const;
+
+    /// Tags starting with `prefix`, most used first; ties in byte order
+    std::vector<std::pair<std::string_view, uint32_t>> complete(std::string_view prefix) const;
+
+    /// Number of indexed tags
+    size_t size() const { return size_; }
+
+  private:
+    std::string_view entry(size_t i) const;
+
+    // owned when built, otherwise views into `map_`
+    std::string owned_text_;
+    std::vector<uint32_t> owned_offsets_, owned_counts_;
+    std::shared_ptr<cache_file> map_;
+    std::string_view text_;             // sorted tags back to back
+    const uint32_t* offsets_ = nullptr; // start of each tag in `text_`; one extra at the end
+    const uint32_t* counts_ = nullptr;  // tasks carrying each tag
+    size_t size_ = 0;
+};
+#endif // COMPLETE_H
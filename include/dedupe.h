@@ -0,0 +1,57 @@
+#ifndef DEDUPE_H
+#define DEDUPE_H
+#include "cache.h"
+#include "hash_map.h"
+#include <cstdint>
+#include <filesystem>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// What `add` does with a task already in the file
+enum class dupe_mode
+{
+    allow,  // add without checking
+    flag,   // warn, then add
+    reject, // refuse to add
+};
+
+/// Fingerprint of `line` with case and spacing normalized away, so lines that
+/// differ only in those get the same fingerprint
+/// @param `scratch` Reused buffer for the normalized text
+uint64_t line_fingerprint(std::string_view line, std::string& scratch);
+
+/// Set of 64-bit line fingerprints.
+/// Membership is decided by fingerprint alone; lines are never compared.
+class fingerprint_set
+{
+  public:
+    explicit fingerprint_set(size_t capacity = 0) : counts_(0, capacity) {}
+
+    /// Add `print`
+    /// @return bool Whether it was not yet present
+    bool insert(uint64_t print);
+
+    bool contains(uint64_t print) const;
+
+    size_t size() const { return counts_.size(); }
+
+    /// Fingerprints of every non-empty line of `buffer`, in one pass
+    static fingerprint_set of(std::string_view buffer);
+
+    /// Load a cache written for a file with `stamp`
+    bool load(const std::filesystem::path& path, const file_stamp& stamp);
+
+    /// Persist to `path`, tied to `stamp`
+    bool save(const std::filesystem::path& path, const file_stamp& stamp) const;
+
+  private:
+    hash_map<uint32_t> counts_; // fingerprint -> lines with it
+};
+
+/// Drop every non-empty line of `buffer` whose normalized text appeared earlier
+/// @param `removed` Set to the dropped lines
+/// @return std::string Remaining lines, each ending in a newline
+std::string dedupe_lines(std::string_view buffer, std::vector<std::string_view>& removed);
+#endif // DEDUPE_H
@@ -0,0 +1,42 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+#include "intern.h"
+#include "task.h"
+#include "width.h"
+#include <array>
+#include <memory_resource>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Escape sequences of the highlighted spans, looked up once before formatting
+struct palette
+{
+    std::array<std::string, 7> colors; // indexed by `span_kind`
+    std::string reset;
+
+    /// Colors used in the terminal
+    static palette current();
+};
+
+/// Parse lines of a todo.txt file, interning tags
+/// @param `tags` Intern table to fill with contexts, projects and keys
+/// @param `mr` Memory resource backing the result
+/// @return Parsed tasks, viewing into `lines`
+std::pmr::vector<task> parse_lines(const std::pmr::vector<std::string_view>& lines,
+                                   intern_table& tags, std::pmr::memory_resource* mr);
+
+/// Format tasks for the terminal, highlighting the spans found by `lex_line`.
+/// Text between spans is copied as-is, spacing included. Allocates from `mr` only.
+/// @param `paint` Escape sequences for the spans
+/// @param `mr` Memory resource backing the result
+/// @param `overflow` How to lay out lines wider than `cols`
+/// @param `cols` Terminal width
+/// @param `show_ids` Prefix each line with the task's stable id
+/// @return Formatted lines joined together
+std::pmr::string format_lines(const std::pmr::vector<task>& tasks, const palette& paint,
+                              std::pmr::memory_resource* mr,
+                              overflow_mode overflow = overflow_mode::none, size_t cols = 0,
+                              bool show_ids = false);
+#endif // FORMAT_H
@@ -0,0 +1,55 @@
+#ifndef FUZZY_H
+#define FUZZY_H
+#include <climits>
+#include <cstdint>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Score returned by `fuzzy_score` when `pattern` is not a subsequence of `text`
+constexpr int no_match = INT_MIN;
+
+/// fzf-style (v1) score of `pattern` as an ASCII case-insensitive subsequence of `text`.
+/// The shortest window ending at the first full match is scored: points per matched
+/// byte, bonuses for word starts, camelCase humps and consecutive runs, and
+/// penalties for gaps.
+/// @param `folded` `text` with ASCII letters lowercased
+/// @param `pattern` Lowercase query
+int fuzzy_score(std::string_view text, std::string_view folded, std::string_view pattern);
+
+/// One ranked line
+struct fuzzy_match
+{
+    int score;
+    uint32_t index; // into the lines given to `fuzzy_matcher`
+};
+
+/// Incremental top-K fuzzy search over a fixed set of lines.
+/// Every call remembers which lines matched; when the next query extends the
+/// previous one only those lines are rescored, since a line that does not
+/// contain `abc` as a subsequence cannot contain `abcd` either.
+class fuzzy_matcher
+{
+  public:
+    /// @param `lines` Lines to search; must outlive the matcher
+    /// @param `threads` Workers for large candidate sets (0 = one per core)
+    explicit fuzzy_matcher(const std::vector<std::string_view>& lines, unsigned threads = 0);
+
+    /// Best `limit` matches of `query`, best first; ties keep file order
+    std::vector<fuzzy_match> search(std::string_view query, size_t limit);
+
+    /// Lines scored by the last `search`
+    size_t scored() const { return scored_; }
+
+  private:
+    const std::vector<std::string_view>& lines_;
+    unsigned threads_;
+    std::string folded_;             // all lines lowercased, back to back
+    std::vector<uint32_t> starts_;   // offset of each line in `folded_`; one extra at the end
+    std::string query_;              // last query, lowercased
+    std::vector<uint32_t> matched_;  // lines matching `query_`, ascending
+    bool all_ = true;                // no query yet: every line is a candidate
+    size_t scored_ = 0;
+};
+#endif // FUZZY_H
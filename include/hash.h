@@ -0,0 +1,46 @@
+#ifndef HASH_H
+#define HASH_H
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace detail {
+    constexpr uint64_t hash_k0 = 0x9e3779b97f4a7c15ULL;
+    constexpr uint64_t hash_k1 = 0xbf58476d1ce4e5b9ULL;
+    constexpr uint64_t hash_k2 = 0x94d049bb133111ebULL;
+
+    inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    /// Final avalanche step (splitmix64)
+    inline uint64_t fmix(uint64_t h)
+    {
+        h = (h ^ (h >> 30)) * hash_k1;
+        h = (h ^ (h >> 27)) * hash_k2;
+        return h ^ (h >> 31);
+    }
+} // namespace detail
+
+/// Fast non-cryptographic 64-bit hash of `str`.
+/// Consumes 8 bytes per round; used for interning, line fingerprints and task ids.
+/// @param `str` Bytes to hash
+/// @param `seed` Optional seed to derive independent hash families
+inline uint64_t hash64(std::string_view str, uint64_t seed = 0)
+{
+    const char* p = str.data();
+    size_t len = str.size();
+    uint64_t h = seed ^ (len * detail::hash_k0);
+    while (len >= 8) {
+        uint64_t k;
+        std::memcpy(&k, p, 8);
+        h = detail::rotl(h ^ (k * detail::hash_k1), 29) * detail::hash_k0;
+        p += 8;
+        len -= 8;
+    }
+    if (len > 0) {
+        uint64_t k = 0;
+        std::memcpy(&k, p, len);
+        h = detail::rotl(h ^ (k * detail::hash_k1), 29) * detail::hash_k0;
+    }
+    return detail::fmix(h);
+}
+#endif // HASH_H
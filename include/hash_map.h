@@ -0,0 +1,110 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+#include <cstdint>
+#include <memory_resource>
+#include <stddef.h>
+#include <vector>
+
+/// Open-addressing hash map keyed by precomputed 64-bit hashes (`hash64`
+/// output, fingerprints, ids). Such keys are already well mixed, so their low
+/// bits pick the slot directly; probing is linear and the table doubles to keep
+/// its load at or below one half. A slot is free while its value equals the
+/// `empty` value given at construction, which callers pick from outside their
+/// value range. Several entries may share a key (e.g. strings whose hashes
+/// collide); `find` takes a predicate to tell them apart.
+template <typename V>
+class hash_map
+{
+  public:
+    struct slot
+    {
+        uint64_t key;
+        V value;
+    };
+
+    explicit hash_map(V empty, size_t capacity = 0,
+                      std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : empty_(empty), slots_(mr)
+    {
+        size_t n = 16;
+        while (n < capacity * 2) n <<= 1;
+        slots_.assign(n, slot{0, empty_});
+    }
+
+    /// Value of the first entry with `key` whose value satisfies `match`, or `nullptr`
+    template <typename Match>
+    V* find(uint64_t key, Match&& match)
+    {
+        const size_t mask = slots_.size() - 1;
+        for (size_t i = key & mask; slots_[i].value != empty_; i = (i + 1) & mask) {
+            if (slots_[i].key == key && match(slots_[i].value)) return &slots_[i].value;
+        }
+        return nullptr;
+    }
+
+    template <typename Match>
+    const V* find(uint64_t key, Match&& match) const
+    {
+        return const_cast<hash_map*>(this)->find(key, match);
+    }
+
+    V* find(uint64_t key)
+    {
+        return find(key, [](const V&) { return true; });
+    }
+
+    const V* find(uint64_t key) const
+    {
+        return find(key, [](const V&) { return true; });
+    }
+
+    /// Add an entry for `key`, even if there is one already.
+    /// References to values are invalidated.
+    /// @param `value` Must not equal the empty value
+    V& insert(uint64_t key, V value)
+    {
+        if ((size_ + 1) * 2 > slots_.size()) grow();
+        ++size_;
+        return place(key, value);
+    }
+
+    /// Fetch the first slot of `key` into cache ahead of a lookup
+    void prefetch(uint64_t key) const { __builtin_prefetch(&slots_[key & (slots_.size() - 1)]); }
+
+    /// Number of entries
+    size_t size() const { return size_; }
+
+    /// Call `fn(key, value)` for each entry, in slot order
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (const auto& s : slots_) {
+            if (s.value != empty_) fn(s.key, s.value);
+        }
+    }
+
+  private:
+    V& place(uint64_t key, V value)
+    {
+        const size_t mask = slots_.size() - 1;
+        size_t i = key & mask;
+        while (slots_[i].value != empty_) i = (i + 1) & mask;
+        slots_[i] = slot{key, value};
+        return slots_[i].value;
+    }
+
+    void grow()
+    {
+        std::pmr::vector<slot> old(slots_.size() * 2, slot{0, empty_},
+                                   slots_.get_allocator().resource());
+        old.swap(slots_);
+        for (const auto& s : old) {
+            if (s.value != empty_) place(s.key, s.value);
+        }
+    }
+
+    V empty_;
+    std::pmr::vector<slot> slots_; // power-of-two sized
+    size_t size_ = 0;
+};
+#endif // HASH_MAP_H
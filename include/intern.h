@@ -0,0 +1,49 @@
+#ifndef INTERN_H
+#define INTERN_H
+#include "hash_map.h"
+#include <cstdint>
+#include <memory_resource>
+#include <stddef.h>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// String interning table.
+/// Maps each distinct string to a small dense id so that tags can be compared
+/// and grouped as integers. Text is copied once into an append-only arena;
+/// lookups go through a `hash_map` from each string's 64-bit hash to its id.
+class intern_table
+{
+  public:
+    using id_type = uint32_t;
+    static constexpr id_type npos = UINT32_MAX;
+
+    explicit intern_table(size_t capacity = 256,
+                          std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+    ~intern_table();
+    intern_table(const intern_table&) = delete;
+    intern_table& operator=(const intern_table&) = delete;
+
+    /// Get id of `str`, adding it to the table if not yet present
+    id_type intern(std::string_view str);
+
+    /// Get id of `str` without inserting, or `npos` if unknown
+    id_type find(std::string_view str) const;
+
+    /// Text of previously interned id
+    std::string_view resolve(id_type id) const { return strings_[id]; }
+
+    /// Number of distinct strings
+    size_t size() const { return strings_.size(); }
+
+  private:
+    std::string_view store(std::string_view str);
+
+    std::pmr::memory_resource* mr_;
+    hash_map<id_type> ids_;                      // hash -> id
+    std::pmr::vector<std::string_view> strings_; // id -> text in arena
+    std::pmr::vector<std::pair<char*, size_t>> blocks_;
+    char* cursor_ = nullptr;
+    size_t remaining_ = 0;
+};
+#endif // INTERN_H
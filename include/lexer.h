@@ -0,0 +1,34 @@
+#ifndef LEXER_H
+#define LEXER_H
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+/// Kind of highlighted token in a todo.txt line
+enum class span_kind : uint8_t
+{
+    done,     // leading `x`
+    priority, // leading `(A)`
+    date,     // completion or creation date in the header
+    context,  // @context
+    project,  // +project
+    key,      // key:value
+    url,      // scheme://...
+};
+
+/// Highlighted token of a line; text between spans is plain
+struct line_span
+{
+    uint32_t offset, length;
+    span_kind kind;
+};
+
+/// Split `line` into highlighted spans in a single pass.
+/// Bytes are mapped to classes by lookup table and each word is run through a
+/// small DFA; words that can no longer become a token are skipped with memchr.
+/// Tokens follow `parse_header` and `classify_word`, so words are separated by
+/// spaces only and the header ends at the first word that is not part of it.
+/// @param `spans` Replaced with the spans of `line`, in order
+void lex_line(std::string_view line, std::pmr::vector<line_span>& spans);
+#endif // LEXER_H
@@ -0,0 +1,196 @@
+#ifndef LOG_H
+#define LOG_H
+#include "config.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fmt/format.h>
+#include <loguru.hpp>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+#ifndef LOG_VERBOSITY_FLOOR
+#define LOG_VERBOSITY_FLOOR 9
+#endif
+
+/// Asynchronous logging for hot paths.
+///
+/// Call sites above the compile-time `LOG_VERBOSITY_FLOOR` compile to nothing.
+/// Enabled records are pushed onto a lock-free ring as raw format arguments
+/// and formatted/written by a background thread (or drained at exit), so a
+/// log statement costs a few stores instead of formatting + a locked write.
+/// The thread is started by the first record queued, so runs that log nothing
+/// never pay for it.
+///
+/// | Macro                  | Like loguru's         |
+/// |------------------------|-----------------------|
+/// | `ALOG_F(INFO, ...)`    | `LOG_F(INFO, ...)`    |
+/// | `VALOG_F(2, ...)`      | `VLOG_F(2, ...)`      |
+#define VALOG_F(verbosity, ...)                                                                    \
+    do {                                                                                           \
+        if constexpr ((verbosity) <= LOG_VERBOSITY_FLOOR) {                                        \
+            if ((verbosity) <= alog::current_verbosity())                                          \
+                alog::log((verbosity), __FILE__, __LINE__, __VA_ARGS__);                           \
+        }                                                                                          \
+    } while (false)
+#define ALOG_F(verbosity_name, ...) VALOG_F(loguru::Verbosity_##verbosity_name, __VA_ARGS__)
+
+namespace alog {
+    constexpr size_t payload_size = 192;
+
+    struct record;
+    using decoder = void (*)(const record&, fmt::memory_buffer&);
+
+    /// Queued log statement: format arguments are stored raw in `payload`
+    struct record
+    {
+        decoder decode;
+        const char* format; // string literal at call site
+        const char* file;
+        unsigned line;
+        int verbosity;
+        int64_t time_ns;
+        alignas(8) char payload[payload_size];
+    };
+
+    namespace detail {
+        inline std::atomic<int> g_verbosity{loguru::Verbosity_OFF};
+
+        /// How a single argument is copied into and read back from a record
+        template <typename T, typename = void>
+        struct codec
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "log argument must be trivially copyable "
+                                                           "or string-like");
+            using stored = T;
+            static void encode(char*& out, const T& v)
+            {
+                std::memcpy(out, &v, sizeof(T));
+                out += sizeof(T);
+            }
+            static stored decode(const char*& in)
+            {
+                T v;
+                std::memcpy(&v, in, sizeof(T));
+                in += sizeof(T);
+                return v;
+            }
+        };
+
+        /// Strings are copied by value (length-prefixed) so the caller's buffer may go away
+        template <typename T>
+        struct codec<T, std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>>
+        {
+            using stored = std::string_view;
+            static std::string_view view(const T& v)
+            {
+                if constexpr (std::is_pointer_v<T>) {
+                    if (v == nullptr) return "(null)";
+                }
+                return std::string_view(v);
+            }
+            static void encode(char*& out, const T& v, size_t room)
+            {
+                auto str = view(v);
+                auto n = static_cast<uint32_t>(std::min(str.size(), room - sizeof(uint32_t)));
+                std::memcpy(out, &n, sizeof(n));
+                std::memcpy(out + sizeof(n), str.data(), n);
+                out += sizeof(n) + n;
+            }
+            static stored decode(const char*& in)
+            {
+                uint32_t n;
+                std::memcpy(&n, in, sizeof(n));
+                std::string_view str(in + sizeof(n), n);
+                in += sizeof(n) + n;
+                return str;
+            }
+        };
+
+        template <typename T>
+        using codec_for = codec<std::decay_t<T>>;
+
+        template <typename T>
+        constexpr bool is_string_codec = std::is_same_v<typename codec_for<T>::stored,
+                                                        std::string_view>;
+
+        template <typename... Args>
+        void decode(const record& rec, fmt::memory_buffer& out)
+        {
+            [[maybe_unused]] const char* in = rec.payload;
+            // braced init guarantees left-to-right evaluation
+            std::tuple<typename codec_for<Args>::stored...> args{codec_for<Args>::decode(in)...};
+            std::apply(
+                [&](auto&... a) {
+                    auto text = fmt::vformat(rec.format, fmt::make_format_args(a...));
+                    out.append(text.data(), text.data() + text.size());
+                },
+                args);
+        }
+
+        template <typename T>
+        void encode(char*& out, char* end, const T& v)
+        {
+            if constexpr (is_string_codec<T>) {
+                codec_for<T>::encode(out, v, static_cast<size_t>(end - out));
+            } else {
+                codec_for<T>::encode(out, v);
+            }
+        }
+
+        /// Reserve a slot in the ring; `nullptr` if full (the record is dropped)
+        record* acquire();
+        /// Publish a slot returned by `acquire()`, starting the writer thread if
+        /// this is the first record
+        void commit(record* rec);
+    } // namespace detail
+
+    /// Current runtime verbosity
+    inline int current_verbosity() { return detail::g_verbosity.load(std::memory_order_relaxed); }
+
+    /// Change runtime verbosity
+    void set_verbosity(int verbosity);
+
+    /// Drain remaining records and stop the writer thread
+    void stop();
+
+    /// Queue a log record. Prefer the `ALOG_F` / `VALOG_F` macros.
+    template <typename... Args>
+    void log(int verbosity, const char* file, unsigned line, const char* format,
+             const Args&... args)
+    {
+        // fixed-size args must always fit; strings are truncated to what is left
+        constexpr size_t fixed =
+            (size_t{0} + ... +
+             (detail::is_string_codec<Args> ? sizeof(uint32_t) : sizeof(std::decay_t<Args>)));
+        static_assert(fixed <= payload_size, "too many log arguments");
+
+        record* rec = detail::acquire();
+        if (rec == nullptr) return;
+        rec->decode = &detail::decode<Args...>;
+        rec->format = format;
+        rec->file = file;
+        rec->line = line;
+        rec->verbosity = verbosity;
+        rec->time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count();
+        [[maybe_unused]] char* out = rec->payload;
+        [[maybe_unused]] size_t reserved = fixed;
+        // each string may use whatever the remaining fixed-size args do not need
+        (
+            [&] {
+                reserved -= detail::is_string_codec<Args> ? sizeof(uint32_t)
+                                                          : sizeof(std::decay_t<Args>);
+                detail::encode(out, rec->payload + payload_size - reserved, args);
+            }(),
+            ...);
+        detail::commit(rec);
+    }
+} // namespace alog
+#endif // LOG_H
@@ -0,0 +1,70 @@
+#ifndef MERGE_H
+#define MERGE_H
+#include "cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <stddef.h>
+#include <string_view>
+#include <vector>
+
+/// Every line of `buffer`, empty ones included; a final newline ends the last line
+std::vector<std::string_view> split_all_lines(std::string_view buffer);
+
+/// 64-bit fingerprint of each line
+std::vector<uint64_t> fingerprint_lines(const std::vector<std::string_view>& lines);
+
+/// Shortest edit script between `a` and `b` (Myers, linear space).
+/// @return std::vector<int32_t> For each element of `a`, index of the element
+/// of `b` it is kept as, or -1 if it was deleted
+std::vector<int32_t> diff_matches(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b);
+
+/// Region of base changed differently on both sides
+struct merge_conflict
+{
+    size_t base_line; // 0-based start in base (in ours for `merge2`)
+    std::vector<std::string_view> base, ours, theirs;
+};
+
+struct merge_result
+{
+    std::vector<std::string_view> lines;
+    std::vector<merge_conflict> conflicts;
+};
+
+/// Line-based three-way merge.
+/// A region changed on one side only takes that side; a region changed the
+/// same way on both sides is taken once. Lines both sides insert at the
+/// same place are kept, ours first, since tasks do not depend on their
+/// neighbours; a line both insert is kept once. Anything else is a conflict.
+merge_result merge3(const std::vector<std::string_view>& base,
+                    const std::vector<std::string_view>& ours,
+                    const std::vector<std::string_view>& theirs);
+
+/// Line-based two-way merge, for when there is no base.
+/// Without one, a line added on one side cannot be told from a line deleted
+/// on the other, nor an edit from an unrelated task, so every region where
+/// the sides differ is a conflict.
+merge_result merge2(const std::vector<std::string_view>& ours,
+                    const std::vector<std::string_view>& theirs);
+
+/// Dropbox conflicted copies of `fpath`, e.g. `todo (laptop's conflicted copy 2019-06-01).txt`
+std::vector<std::filesystem::path> conflicted_copies(const std::filesystem::path& fpath);
+
+/// Path of the merge base of todo.txt `fpath`: the last version of it this
+/// machine shared with the others, kept per machine by `state_path`
+std::filesystem::path merge_base_path(const std::filesystem::path& fpath);
+
+/// Replace todo.txt `fpath` with `pieces`, keeping its merge base current.
+/// `current` (read at `stamp`) becomes the base unless ctodo wrote it itself:
+/// a version that changed behind ctodo's back came from a sync, so the other
+/// machines have it, while ctodo's own writes may not have reached them yet.
+/// The base is left alone while conflicted copies wait to be merged.
+/// @return bool Whether todo.txt was written; a base that cannot be saved is only logged
+bool write_todo_file(const std::filesystem::path& fpath, const file_stamp& stamp,
+                     std::string_view current, const std::vector<std::string_view>& pieces);
+
+/// Replace todo.txt `fpath` with `merged`, the result of merging its conflicted
+/// copies, which both sides now share and so is also the new base
+/// @return bool Whether todo.txt was written
+bool write_merged_file(const std::filesystem::path& fpath, std::string_view merged);
+#endif // MERGE_H
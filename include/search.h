@@ -0,0 +1,62 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+#include "cache.h"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Position of `needle` in `haystack` ignoring ASCII case, or `npos`.
+/// Candidate positions are found 16 bytes at a time by matching the first
+/// and last byte of `needle`, then verified.
+size_t icase_find(std::string_view haystack, std::string_view needle, size_t pos = 0);
+
+/// Case-insensitive substring index over the non-empty lines of a buffer.
+/// Each line is posted under every trigram it contains; a query intersects
+/// the posting lists of its trigrams and only verifies the surviving lines.
+/// Bytes are folded into 64 classes (digits and letters exact, case-folded),
+/// so postings may over-match but never miss.
+class trigram_index
+{
+  public:
+    /// Index non-empty lines of `buffer`
+    void build(std::string_view buffer);
+
+    /// Map a cache written for a file with `stamp`
+    bool load(const std::filesystem::path& path, const file_stamp& stamp);
+
+    /// Persist to `path`, tied to `stamp`
+    bool save(const std::filesystem::path& path, const file_stamp& stamp) const;
+
+    /// Indices of lines containing every one of `terms`, in file order
+    /// @param `buffer` Same contents the index was built from
+    std::vector<uint32_t> find(std::string_view buffer,
+                               const std::vector<std::string_view>& terms) const;
+
+    /// Text of line `i`
+    std::string_view line(std::string_view buffer, uint32_t i) const;
+
+    /// Number of indexed lines
+    size_t size() const { return line_count_; }
+
+  private:
+    struct span
+    {
+        const uint32_t* data;
+        size_t size;
+    };
+    span postings(uint32_t key) const;
+    std::vector<uint32_t> scan(std::string_view buffer, std::string_view term) const;
+
+    // owned when built, otherwise views into `map_`
+    std::vector<uint32_t> owned_starts_, owned_offsets_, owned_postings_;
+    std::shared_ptr<cache_file> map_;
+    const uint32_t* starts_ = nullptr;   // byte offset of each line
+    const uint32_t* offsets_ = nullptr;  // per key: first posting; one extra at the end
+    const uint32_t* postings_ = nullptr; // line numbers grouped by key, ascending
+    size_t line_count_ = 0;
+};
+#endif // SEARCH_H
@@ -0,0 +1,63 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include "cache.h"
+#include <filesystem>
+#include <memory>
+#include <string_view>
+
+/// Exclusive advisory lock serializing the writers of a file.
+/// Taken with flock on a sidecar (`.todo.txt.lock`) rather than on the file:
+/// writers replace the file by rename, and a lock on the old inode would not
+/// exclude a writer that opened the new one. Readers never take it.
+class file_lock
+{
+  public:
+    /// Block until the lock for `fpath` is held
+    explicit file_lock(const std::filesystem::path& fpath);
+    ~file_lock();
+    file_lock(const file_lock&) = delete;
+    file_lock& operator=(const file_lock&) = delete;
+
+    /// Whether the lock is held; false if the lock file could not be opened
+    bool locked() const { return fd_ >= 0; }
+
+  private:
+    int fd_ = -1;
+};
+
+/// Read-only mapping of one generation of a file, taken without locking.
+/// Writers publish a new inode by `write_file_atomic`, so an inode once opened
+/// never changes. The stamp of the open descriptor (inode, size, mtime) is the
+/// generation marker: `intact` re-checks it to catch tools that rewrite the
+/// file in place, whose changes would otherwise show through the mapping.
+class file_snapshot
+{
+  public:
+    ~file_snapshot();
+    file_snapshot(const file_snapshot&) = delete;
+    file_snapshot& operator=(const file_snapshot&) = delete;
+
+    /// Map the file at `fpath` as it is now, or `nullptr` if it cannot be opened
+    static std::shared_ptr<file_snapshot> open(const std::filesystem::path& fpath);
+
+    std::string_view text() const { return {static_cast<const char*>(map_), stamp_.size}; }
+
+    /// Copy the contents with `pread` instead of through the mapping, which
+    /// raises SIGBUS if the file is truncated in place while being read.
+    /// @param `out` Room for `stamp().size` bytes
+    /// @return bool Whether all of them were read; check `intact()` afterwards
+    bool read(char* out) const;
+
+    /// Generation of the mapped contents
+    const file_stamp& stamp() const { return stamp_; }
+
+    /// Whether the mapped inode is still the generation it was opened at
+    bool intact() const;
+
+  private:
+    file_snapshot() = default;
+    int fd_ = -1;
+    void* map_ = nullptr;
+    file_stamp stamp_{0, 0, 0};
+};
+#endif // SNAPSHOT_H
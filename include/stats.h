@@ -0,0 +1,41 @@
+#ifndef STATS_H
+#define STATS_H
+#include <array>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/// Age buckets of open tasks: 1 week, 1 month, 3 months, 1 year, older, undated
+constexpr size_t age_buckets = 6;
+
+/// Weeks of completion history kept for velocity
+constexpr size_t velocity_weeks = 12;
+
+/// Counters gathered in one pass over a todo.txt or done.txt buffer
+struct task_stats
+{
+    size_t total = 0, done = 0;
+    std::array<size_t, 27> priority{};          // open tasks by 'A'-'Z'; [26] = none
+    std::array<size_t, age_buckets> age{};      // open tasks by days since creation
+    std::array<size_t, velocity_weeks> weekly{}; // completions by weeks ago
+    size_t lead_days = 0, lead_count = 0;       // creation to completion, where both known
+    std::vector<std::pair<std::string_view, size_t>> tags; // contexts/projects of open tasks;
+                                                           // views into the scanned buffer
+};
+
+/// Add counters of `from` into `into`
+void merge_stats(task_stats& into, const task_stats& from);
+
+/// Scan `buffer` once, split across up to `threads` workers (0 = one per core).
+/// Each worker fills its own counters, which are merged at the end.
+/// @param `buffer` Contents of todo.txt or done.txt
+/// @param `today` Current date as days since 1970-01-01
+task_stats collect_stats(std::string_view buffer, int today, unsigned threads = 0);
+
+/// Human-readable report
+/// @param `todo` Stats of todo.txt
+/// @param `done` Stats of done.txt
+std::string format_stats(const task_stats& todo, const task_stats& done);
+#endif // STATS_H
@@ -0,0 +1,122 @@
+#ifndef TASK_H
+#define TASK_H
+#include "intern.h"
+#include <climits>
+#include <cstring>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Kind of tag found in a task line
+enum class tag_kind : uint8_t
+{
+    none,
+    context, // @context
+    project, // +project
+    key,     // key:value
+};
+
+/// Interned tag occurrence. Ids for keys refer to the `key:` part only.
+struct tag_ref
+{
+    intern_table::id_type id;
+    tag_kind kind;
+};
+
+/// Parsed line of todo.txt
+struct task
+{
+    std::string_view text;
+    std::pmr::vector<tag_ref> tags; // in order of appearance
+    uint64_t id = 0;                // stable id, once assigned from `task_ids`
+};
+
+/// Call `fn` with each line of `buffer`, empty ones included, without the newline.
+/// A final newline does not start another line.
+template <typename Fn>
+void for_each_line(std::string_view buffer, Fn&& fn)
+{
+    const char* pos = buffer.data();
+    const char* end = pos + buffer.size();
+    while (pos < end) {
+        auto nl = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+        if (nl == nullptr) nl = end;
+        fn(std::string_view(pos, nl - pos));
+        pos = nl + 1;
+    }
+}
+
+/// Call `fn` with each space-delimited, non-empty word of `line`, without allocating
+template <typename Fn>
+void for_each_word(std::string_view line, Fn&& fn)
+{
+    size_t pos = 0, len = line.size();
+    while (pos < len) {
+        while (pos < len && line[pos] == ' ') ++pos;
+        size_t end = pos;
+        while (end < len && line[end] != ' ') ++end;
+        if (end > pos) fn(line.substr(pos, end - pos));
+        pos = end;
+    }
+}
+
+/// Lowercase ASCII letters of `text` and collapse runs of spaces and tabs into one
+/// space, dropping them at both ends
+/// @param `out` Replaced with the result
+void normalize_text(std::string_view text, std::string& out);
+
+/// As above, writing to `out`, which must have room for `text.size()` bytes
+/// @return size_t Length of the result
+size_t normalize_text(std::string_view text, char* out);
+
+/// Classify a single whitespace-delimited word
+/// @param `word` Word to classify
+/// @param `interned` Set to the part of `word` that is interned
+tag_kind classify_word(std::string_view word, std::string_view& interned);
+
+/// Parse tags of `line`, interning them into `tags`
+/// @param `mr` Resource for the task's tag list
+task parse_task(std::string_view line, intern_table& tags,
+                std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+
+/// Marks a missing date in `task_header`
+constexpr int no_date = INT_MIN;
+
+/// Leading fields of a todo.txt line
+struct task_header
+{
+    bool done;
+    char priority; // 'A'-'Z', or 0
+    int completed; // days since 1970-01-01, or `no_date`
+    int created;   // days since 1970-01-01, or `no_date`
+    size_t offset; // byte offset of the description
+};
+
+/// Parse done marker, priority and dates at the start of `line`
+task_header parse_header(std::string_view line);
+
+/// Format days since 1970-01-01 as YYYY-MM-DD
+std::string format_date(int days);
+
+/// Byte offset of the description in `line`, past any done marker, priority and dates
+size_t text_offset(std::string_view line);
+
+/// Parse a YYYY-MM-DD date into days since 1970-01-01
+/// @param `word` Text to parse
+/// @param `days` Set on success
+bool parse_date(std::string_view word, int& days);
+
+/// Today's local date as days since 1970-01-01
+int current_day();
+
+/// Whether `t` carries tag `id`
+bool has_tag(const task& t, intern_table::id_type id);
+
+/// Keep tasks matching all `terms`.
+/// `@context` and `+project` terms are resolved to ids and compared as integers;
+/// any other term is a case-insensitive substring match.
+void filter_tasks(std::pmr::vector<task>& tasks, const std::vector<std::string>& terms,
+                  const intern_table& tags);
+#endif // TASK_H
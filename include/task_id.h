@@ -0,0 +1,52 @@
+#ifndef TASK_ID_H
+#define TASK_ID_H
+#include "hash_map.h"
+#include <cstdint>
+#include <memory_resource>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Stable, content-addressed ids of the lines of a todo.txt file.
+/// An id hashes the task's description (lowercased, single-spaced, without
+/// done marker, priority or dates) salted with its creation date, so it
+/// survives reordering, archiving, reprioritizing and completion. The n-th
+/// identical task gets the n-th derived id, in file order. Lookup goes through
+/// a `hash_map` keyed by the id itself.
+/// Ids are `id_bits` wide and written as `id_chars` base-32 characters.
+class task_ids
+{
+  public:
+    static constexpr unsigned id_bits = 40;
+    static constexpr size_t id_chars = id_bits / 5;
+    static constexpr size_t npos = SIZE_MAX;
+
+    /// Assign ids to `lines`, in order
+    /// @param `mr` Memory resource backing the ids and their index
+    explicit task_ids(const std::pmr::vector<std::string_view>& lines,
+                      std::pmr::memory_resource* mr = std::pmr::get_default_resource());
+
+    /// Id of line `i`
+    uint64_t id(size_t i) const { return ids_[i]; }
+
+    /// Index of the line with `id`, or `npos`
+    size_t find(uint64_t id) const;
+
+    /// Index of the line named by `arg`: an id, or a 1-based task number.
+    /// Task numbers count every line of the file, blank ones included, as todo.sh does.
+    /// @param `numbers` Task number of each line, ascending (see `split_lines`)
+    /// @return size_t Line index, or `npos` if `arg` names no line
+    size_t resolve(std::string_view arg, const std::pmr::vector<uint32_t>& numbers) const;
+
+    /// Printable form of `id`
+    static std::string format(uint64_t id);
+
+    /// Parse printable id `text`
+    static bool parse(std::string_view text, uint64_t& id);
+
+  private:
+    std::pmr::vector<uint64_t> ids_;
+    hash_map<uint32_t> lines_; // id -> line
+};
+#endif // TASK_ID_H
@@ -0,0 +1,32 @@
+#ifndef WIDTH_H
+#define WIDTH_H
+#include <memory_resource>
+#include <stddef.h>
+#include <string>
+#include <string_view>
+
+/// How lines longer than the terminal are laid out
+enum class overflow_mode
+{
+    none,     // emit as-is
+    wrap,     // soft-wrap at spaces with a hanging indent
+    truncate, // cut and end with an ellipsis
+};
+
+/// Terminal columns taken by `cp` (0, 1 or 2)
+int codepoint_width(char32_t cp);
+
+/// Terminal columns taken by UTF-8 `str`, ignoring ANSI escape sequences
+size_t display_width(std::string_view str);
+
+/// Length in bytes of the longest prefix of `str` that fits in `max_width` columns.
+/// Escape sequences directly following the prefix are included.
+size_t width_prefix(std::string_view str, size_t max_width);
+
+/// Soft-wrap rendered `line` to `cols`, continuing lines `indent` columns in
+/// @param `line` Rendered line; may contain ANSI escapes
+/// @param `cols` Terminal width
+/// @param `indent` Hanging indent for continuation lines
+/// @param `out` String to append to
+void wrap_line(std::string_view line, size_t cols, size_t indent, std::pmr::string& out);
+#endif // WIDTH_H
@@ -0,0 +1,54 @@
+#include "arena.h"
+#include "config.h"
+#include <cstdlib>
+#include <new>
+
+void* counting_resource::do_allocate(size_t bytes, size_t alignment)
+{
+    ++allocations_;
+    bytes_ += bytes;
+    return upstream_->allocate(bytes, alignment);
+}
+
+void counting_resource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    upstream_->deallocate(p, bytes, alignment);
+}
+
+bool counting_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    return this == &other;
+}
+
+arena::arena(size_t initial_size)
+    : pool_(initial_size, &counter_)
+{
+    // touch the pool so the initial block is taken now rather than mid-pipeline
+    pool_.deallocate(pool_.allocate(1), 1);
+}
+
+size_t arena_size_for(size_t bytes, size_t lines)
+{
+    // rendered output (colors roughly double tagged words), plus per line: its view, task,
+    // tags, id and id index slots, and the escape sequences around its header
+    return bytes * 3 + lines * 256 + 64 * 1024;
+}
+
+#if COUNT_ALLOCATIONS
+// per thread, so background threads (e.g. the log writer) do not skew the count
+static thread_local size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++g_allocations;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+size_t global_allocations() { return g_allocations; }
+#else
+size_t global_allocations() { return 0; }
+#endif
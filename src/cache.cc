@@ -0,0 +1,199 @@
+#include "cache.h"
+#include "hash.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char cache_magic[8] = {'c', 't', 'o', 'd', 'o', 'c', 'a', '1'};
+
+/// On-disk header; followed by `count` blob sizes, then the 8-byte aligned blobs
+struct cache_header
+{
+    char magic[8];
+    file_stamp stamp;
+    uint64_t count;
+};
+
+static size_t align8(size_t n) { return (n + 7) & ~size_t{7}; }
+
+static file_stamp stamp_of(const struct stat& st)
+{
+    return file_stamp{static_cast<uint64_t>(st.st_size),
+                      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec,
+                      static_cast<uint64_t>(st.st_ino)};
+}
+
+file_stamp file_stamp::of(const std::filesystem::path& fpath)
+{
+    struct stat st;
+    return stat(fpath.c_str(), &st) == 0 ? stamp_of(st) : file_stamp{0, 0, 0};
+}
+
+file_stamp file_stamp::of(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 ? stamp_of(st) : file_stamp{0, 0, 0};
+}
+
+std::filesystem::path sidecar_path(const std::filesystem::path& fpath, std::string_view kind)
+{
+    std::string name = "." + fpath.filename().string() + "." + std::string(kind);
+    return fpath.parent_path() / name;
+}
+
+/// Path of the `kind` file of `fpath` under `<dir>/ctodo`, where `dir` is `$<env>` or
+/// `~/<fallback>`; next to `fpath` if neither is set
+static std::filesystem::path user_path(const char* env, const char* fallback,
+                                       const std::filesystem::path& fpath, std::string_view kind)
+{
+    std::filesystem::path dir;
+    // relative values are invalid per the XDG spec and ignored
+    if (const char* xdg = std::getenv(env); xdg != nullptr && xdg[0] == '/') {
+        dir = xdg;
+    } else if (const char* home = std::getenv("HOME"); home != nullptr && home[0] == '/') {
+        dir = std::filesystem::path(home) / fallback;
+    } else {
+        return sidecar_path(fpath, kind);
+    }
+    std::error_code ec;
+    auto absolute = std::filesystem::absolute(fpath, ec);
+    if (ec) absolute = fpath;
+    char hash[17];
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(hash64(absolute.string())));
+    return dir / "ctodo" / (fpath.filename().string() + "-" + hash + "." + std::string(kind));
+}
+
+std::filesystem::path cache_path(const std::filesystem::path& fpath, std::string_view kind)
+{
+    return user_path("XDG_CACHE_HOME", ".cache", fpath, kind);
+}
+
+std::filesystem::path state_path(const std::filesystem::path& fpath, std::string_view kind)
+{
+    return user_path("XDG_STATE_HOME", ".local/state", fpath, kind);
+}
+
+cache_file::~cache_file()
+{
+    if (map_ != nullptr) munmap(map_, length_);
+}
+
+std::shared_ptr<cache_file> cache_file::open(const std::filesystem::path& path,
+                                             const file_stamp& stamp)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(cache_header)) {
+        close(fd);
+        return nullptr;
+    }
+    const auto length = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return nullptr;
+
+    std::shared_ptr<cache_file> cache(new cache_file);
+    cache->map_ = map;
+    cache->length_ = length;
+
+    const auto base = static_cast<const char*>(map);
+    cache_header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0 ||
+        header.stamp != stamp || header.count > 64) {
+        return nullptr;
+    }
+    size_t pos = sizeof(header) + header.count * sizeof(uint64_t);
+    if (pos > length) return nullptr;
+    for (uint64_t i = 0; i < header.count; ++i) {
+        uint64_t size;
+        std::memcpy(&size, base + sizeof(header) + i * sizeof(uint64_t), sizeof(size));
+        pos = align8(pos);
+        if (size > length || pos + size > length) return nullptr;
+        cache->blobs_.emplace_back(base + pos, size);
+        pos += size;
+    }
+    return cache;
+}
+
+/// Final target of `path` if it is a symlink (possibly dangling), else `path`
+static std::filesystem::path resolve_symlinks(const std::filesystem::path& path)
+{
+    std::filesystem::path target = path;
+    std::error_code ec;
+    for (int hops = 0; hops < 40 && std::filesystem::is_symlink(target, ec); ++hops) {
+        auto link = std::filesystem::read_symlink(target, ec);
+        if (ec) break;
+        target = link.is_absolute() ? link : target.parent_path() / link;
+    }
+    return target;
+}
+
+bool write_file_atomic(const std::filesystem::path& path,
+                       const std::vector<std::string_view>& pieces, bool sync)
+{
+    // replacing a symlink by rename would turn it into a regular file
+    const auto target = resolve_symlinks(path);
+    // unique per call, so concurrent writers never share a temporary file
+    static std::atomic<unsigned> serial{0};
+    std::string tmp = target.string() + ".tmp." + std::to_string(getpid()) + "." +
+                      std::to_string(serial++);
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    if (stat(target.c_str(), &st) == 0) fchmod(fd, st.st_mode & 07777);
+
+    bool ok = true;
+    for (auto piece : pieces) {
+        const char* data = piece.data();
+        size_t n = piece.size();
+        while (ok && n > 0) {
+            ssize_t r = write(fd, data, n);
+            if (r < 0) {
+                ok = false;
+                break;
+            }
+            data += r;
+            n -= static_cast<size_t>(r);
+        }
+    }
+    if (ok && sync) ok = fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (ok) ok = std::rename(tmp.c_str(), target.c_str()) == 0;
+    if (!ok) unlink(tmp.c_str());
+    return ok;
+}
+
+bool save_cache(const std::filesystem::path& path, const file_stamp& stamp,
+                const std::vector<std::string_view>& blobs)
+{
+    cache_header header;
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.stamp = stamp;
+    header.count = blobs.size();
+    std::string head(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto blob : blobs) {
+        uint64_t size = blob.size();
+        head.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+
+    static const char padding[8] = {};
+    std::vector<std::string_view> pieces{head};
+    size_t written = head.size();
+    for (auto blob : blobs) {
+        pieces.emplace_back(padding, align8(written) - written);
+        pieces.push_back(blob);
+        written = align8(written) + blob.size();
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    return write_file_atomic(path, pieces, false);
+}
@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <string>
 #include <string_view>
+#include <sys/ioctl.h>
+#include <unistd.h>
 
 std::ostream& operator<<(std::ostream& out, std::shared_ptr<options> obj)
 {
@@ -14,6 +16,11 @@ std::ostream& operator<<(std::ostream& out, std::shared_ptr<options> obj)
     out << "\n  Verbosity: " << obj->verbosity;
     out << "\n  Quiet: " << obj->quiet;
     out << "\n  Getline: " << obj->getline;
+    out << "\n  Ids: " << obj->ids;
+    out << "\n  Args: " << obj->args;
+    out << "\n  Overflow: " << static_cast<int>(obj->overflow);
+    out << "\n  Limit: " << obj->limit;
+    out << "\n  Dupes: " << static_cast<int>(obj->dupes);
     out << '\n';
     return out;
 }
@@ -21,18 +28,28 @@ std::ostream& operator<<(std::ostream& out, std::shared_ptr<options> obj)
 /// Get runtime terminal size (lines & cols)
 std::shared_ptr<termsize> getTermSize()
 {
-    auto tsize_t = std::make_shared<termsize>();
+    auto tsize_t = std::make_shared<termsize>(termsize{0, 0});
+    // stdout may be piped (e.g. into a pager), so try the other std streams too
+    for (int fd : {STDOUT_FILENO, STDERR_FILENO, STDIN_FILENO}) {
 #if defined(TIOCGSIZE)
-    struct ttysize ts;
-    ioctl(STDIN_FILENO, TIOCGSIZE, &ts);
-    tsize_t->cols = ts.ts_cols;
-    tsize_t->lines = ts.ts_lines;
+        struct ttysize ts;
+        if (ioctl(fd, TIOCGSIZE, &ts) == 0 && ts.ts_cols > 0) {
+            tsize_t->cols = ts.ts_cols;
+            tsize_t->lines = ts.ts_lines;
+            return tsize_t;
+        }
 #elif defined(TIOCGWINSZ)
-    struct winsize ts;
-    ioctl(STDIN_FILENO, TIOCGWINSZ, &ts);
-    tsize_t->cols = ts.ws_col;
-    tsize_t->lines = ts.ws_row;
+        struct winsize ts;
+        if (ioctl(fd, TIOCGWINSZ, &ts) == 0 && ts.ws_col > 0) {
+            tsize_t->cols = ts.ws_col;
+            tsize_t->lines = ts.ws_row;
+            return tsize_t;
+        }
 #endif
+    }
+    if (const char* cols = getenv("COLUMNS"); cols != nullptr) {
+        tsize_t->cols = static_cast<unsigned>(strtoul(cols, nullptr, 10));
+    }
     return tsize_t;
 }
 
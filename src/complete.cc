@@ -0,0 +1,79 @@
+#include "complete.h"
+#include <algorithm>
+#include <numeric>
+
+void tag_index::build(const intern_table& tags, const std::vector<uint32_t>& counts)
+{
+    std::vector<uint32_t> order(tags.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](uint32_t a, uint32_t b) { return tags.resolve(a) < tags.resolve(b); });
+
+    owned_text_.clear();
+    owned_offsets_.clear();
+    owned_counts_.clear();
+    for (auto id : order) {
+        owned_offsets_.push_back(static_cast<uint32_t>(owned_text_.size()));
+        owned_text_.append(tags.resolve(id));
+        owned_counts_.push_back(id < counts.size() ? counts[id] : 0);
+    }
+    owned_offsets_.push_back(static_cast<uint32_t>(owned_text_.size()));
+
+    map_.reset();
+    text_ = owned_text_;
+    offsets_ = owned_offsets_.data();
+    counts_ = owned_counts_.data();
+    size_ = order.size();
+}
+
+bool tag_index::load(const std::filesystem::path& path, const file_stamp& stamp)
+{
+    auto map = cache_file::open(path, stamp);
+    if (map == nullptr || map->size() != 3) return false;
+    const size_t size = map->blob(2).size() / sizeof(uint32_t);
+    if (map->blob(1).size() != (size + 1) * sizeof(uint32_t)) return false;
+    auto data = [&](size_t i) { return reinterpret_cast<const uint32_t*>(map->blob(i).data()); };
+    if (data(1)[size] != map->blob(0).size()) return false;
+    owned_text_.clear();
+    owned_offsets_.clear();
+    owned_counts_.clear();
+    text_ = map->blob(0);
+    offsets_ = data(1);
+    counts_ = data(2);
+    size_ = size;
+    map_ = std::move(map);
+    return true;
+}
+
+bool tag_index::save(const std::filesystem::path& path, const file_stamp& stamp) const
+{
+    if (map_ != nullptr) return true; // already persisted
+    return save_cache(path, stamp, {owned_text_, as_blob(owned_offsets_), as_blob(owned_counts_)});
+}
+
+std::string_view tag_index::entry(size_t i) const
+{
+    return text_.substr(offsets_[i], offsets_[i + 1] - offsets_[i]);
+}
+
+std::vector<std::pair<std::string_view, uint32_t>> tag_index::complete(
+    std::string_view prefix) const
+{
+    // first tag not ordered before `prefix`; all matches follow it contiguously
+    size_t lo = 0, hi = size_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entry(mid) < prefix) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    std::vector<std::pair<std::string_view, uint32_t>> matches;
+    for (size_t i = lo; i < size_ && entry(i).substr(0, prefix.size()) == prefix; ++i) {
+        matches.emplace_back(entry(i), counts_[i]);
+    }
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const auto& a, const auto& b) { return a.second > b.second; });
+    return matches;
+}
@@ -0,0 +1,79 @@
+#include "dedupe.h"
+#include "hash.h"
+#include "task.h"
+#include <algorithm>
+#include <cstring>
+
+uint64_t line_fingerprint(std::string_view line, std::string& scratch)
+{
+    normalize_text(line, scratch);
+    return hash64(scratch);
+}
+
+bool fingerprint_set::insert(uint64_t print)
+{
+    if (uint32_t* count = counts_.find(print)) {
+        ++*count;
+        return false;
+    }
+    counts_.insert(print, 1);
+    return true;
+}
+
+bool fingerprint_set::contains(uint64_t print) const { return counts_.find(print) != nullptr; }
+
+fingerprint_set fingerprint_set::of(std::string_view buffer)
+{
+    fingerprint_set set(std::count(buffer.begin(), buffer.end(), '\n') + 1);
+    std::string scratch;
+    for_each_line(buffer, [&](std::string_view line) {
+        if (!line.empty()) set.insert(line_fingerprint(line, scratch));
+    });
+    return set;
+}
+
+bool fingerprint_set::load(const std::filesystem::path& path, const file_stamp& stamp)
+{
+    auto map = cache_file::open(path, stamp);
+    if (map == nullptr || map->size() != 2) return false;
+    const auto prints = map->blob(0), counts = map->blob(1);
+    const size_t n = prints.size() / sizeof(uint64_t);
+    if (counts.size() != n * sizeof(uint32_t)) return false;
+    counts_ = hash_map<uint32_t>(0, n);
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t print;
+        uint32_t count;
+        std::memcpy(&print, prints.data() + i * sizeof(print), sizeof(print));
+        std::memcpy(&count, counts.data() + i * sizeof(count), sizeof(count));
+        counts_.insert(print, count);
+    }
+    return true;
+}
+
+bool fingerprint_set::save(const std::filesystem::path& path, const file_stamp& stamp) const
+{
+    std::vector<uint64_t> prints;
+    std::vector<uint32_t> counts;
+    prints.reserve(counts_.size());
+    counts.reserve(counts_.size());
+    counts_.for_each([&](uint64_t print, uint32_t count) {
+        prints.push_back(print);
+        counts.push_back(count);
+    });
+    return save_cache(path, stamp, {as_blob(prints), as_blob(counts)});
+}
+
+std::string dedupe_lines(std::string_view buffer, std::vector<std::string_view>& removed)
+{
+    fingerprint_set seen(std::count(buffer.begin(), buffer.end(), '\n') + 1);
+    std::string kept, scratch;
+    kept.reserve(buffer.size() + 1);
+    for_each_line(buffer, [&](std::string_view line) {
+        if (line.empty() || seen.insert(line_fingerprint(line, scratch))) {
+            kept.append(line).push_back('\n');
+        } else {
+            removed.push_back(line);
+        }
+    });
+    return kept;
+}
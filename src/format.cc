@@ -0,0 +1,89 @@
+#include "format.h"
+#include "common.h"
+#include "lexer.h"
+#include "log.h"
+#include "task_id.h"
+#include <algorithm>
+
+std::pmr::vector<task> parse_lines(const std::pmr::vector<std::string_view>& lines,
+                                   intern_table& tags, std::pmr::memory_resource* mr)
+{
+    std::pmr::vector<task> tasks(mr);
+    tasks.reserve(lines.size());
+    for (auto line : lines) {
+        tasks.push_back(parse_task(line, tags, mr));
+    }
+    VALOG_F(1, "Parsed {} tasks with {} distinct tags", tasks.size(), tags.size());
+    return tasks;
+}
+
+palette palette::current()
+{
+    return {{Ansi::setFg(Ansi::Color::gray), Ansi::setFg(Ansi::Color::brred),
+             Ansi::setFg(Ansi::Color::cyan), Ansi::setFg(Ansi::Color::lightorange),
+             Ansi::setFg(Ansi::Color::lime), Ansi::setFg(Ansi::Color::yellow),
+             Ansi::setFg(Ansi::Color::blue)},
+            Ansi::reset()};
+}
+
+std::pmr::string format_lines(const std::pmr::vector<task>& tasks, const palette& paint,
+                              std::pmr::memory_resource* mr, overflow_mode overflow, size_t cols,
+                              bool show_ids)
+{
+    const auto& colors = paint.colors;
+    const std::string& id_color = colors[static_cast<size_t>(span_kind::done)];
+    const std::string& reset = paint.reset;
+    const size_t id_width = show_ids ? task_ids::id_chars + 1 : 0;
+
+    // tags plus a few header spans per line
+    const size_t markup = colors[0].size() + reset.size();
+    size_t size = 0;
+    for (const auto& t : tasks) size += t.text.size() + 1 + (t.tags.size() + 2) * markup;
+    if (show_ids) size += tasks.size() * (markup + id_width);
+    if (cols == 0) overflow = overflow_mode::none;
+    if (overflow == overflow_mode::wrap) {
+        // the hanging indent is at most half a row, so a row holds about as much text
+        // as it adds indent; growing `out` instead would leave a dead copy in the arena
+        const size_t half = std::max<size_t>(cols / 2, 1);
+        for (const auto& t : tasks) {
+            if (t.text.size() + id_width > cols) size += (t.text.size() / half + 1) * (half + 1);
+        }
+    } else if (overflow == overflow_mode::truncate) {
+        size += tasks.size() * (reset.size() + 3); // ellipsis
+    }
+    std::pmr::string out(mr);
+    out.reserve(size);
+    std::pmr::string line(mr);
+    std::pmr::vector<line_span> spans(mr);
+
+    for (size_t i = 0; i < tasks.size(); ++i) {
+        if (i > 0) out.push_back('\n');
+        const auto text = tasks[i].text;
+        // UTF-8 never takes more columns than bytes, so only long lines need layout
+        const bool layout = overflow != overflow_mode::none && text.size() + id_width > cols;
+        auto& dest = layout ? line : out;
+        if (layout) line.clear();
+        if (show_ids) {
+            dest.append(id_color).append(task_ids::format(tasks[i].id)).append(reset);
+            dest.push_back(' ');
+        }
+        lex_line(text, spans);
+        size_t pos = 0;
+        for (const auto& span : spans) {
+            dest.append(text.substr(pos, span.offset - pos));
+            dest.append(colors[static_cast<size_t>(span.kind)]);
+            dest.append(text.substr(span.offset, span.length)).append(reset);
+            pos = span.offset + span.length;
+        }
+        dest.append(text.substr(pos));
+        if (!layout) continue;
+        if (overflow == overflow_mode::wrap) {
+            wrap_line(line, cols, id_width + text_offset(text), out);
+        } else if (display_width(line) <= cols) {
+            out.append(line);
+        } else {
+            out.append(line, 0, width_prefix(line, cols - 1)).append("\u2026").append(reset);
+        }
+    }
+    return out;
+}
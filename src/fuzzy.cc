@@ -0,0 +1,246 @@
+#include "fuzzy.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+/// Fewest lines a scoring worker is given, so short lists stay on the calling
+/// thread and each query answers without waiting on thread start-up
+constexpr size_t min_chunk_lines = 32 * 1024;
+
+// fzf v1 scoring constants
+constexpr int score_match = 16;
+constexpr int score_gap_start = -3;
+constexpr int score_gap_extension = -1;
+constexpr int bonus_boundary = score_match / 2;
+constexpr int bonus_non_word = score_match / 2;
+constexpr int bonus_camel123 = bonus_boundary + score_gap_extension;
+constexpr int bonus_consecutive = -(score_gap_start + score_gap_extension);
+constexpr int bonus_first_char_multiplier = 2;
+
+enum char_class : uint8_t
+{
+    non_word,
+    lower,
+    upper,
+    number,
+};
+
+struct byte_tables
+{
+    std::array<uint8_t, 256> fold{};
+    std::array<char_class, 256> cls{};
+};
+
+static constexpr byte_tables make_tables()
+{
+    byte_tables t{};
+    for (unsigned b = 0; b < 256; ++b) {
+        t.fold[b] = static_cast<uint8_t>(b >= 'A' && b <= 'Z' ? b | 0x20 : b);
+        if (b >= 'a' && b <= 'z') {
+            t.cls[b] = lower;
+        } else if (b >= 'A' && b <= 'Z') {
+            t.cls[b] = upper;
+        } else if (b >= '0' && b <= '9') {
+            t.cls[b] = number;
+        } else {
+            t.cls[b] = b >= 0x80 ? lower : non_word; // treat UTF-8 bytes as letters
+        }
+    }
+    return t;
+}
+static constexpr byte_tables tables = make_tables();
+
+/// Bonus for matching a byte of class `cur` right after one of class `prev`
+static int bonus_for(char_class prev, char_class cur)
+{
+    if (prev == non_word && cur != non_word) return bonus_boundary;
+    if ((prev == lower && cur == upper) || (prev != number && cur == number)) {
+        return bonus_camel123;
+    }
+    if (cur == non_word) return bonus_non_word;
+    return 0;
+}
+
+static uint8_t fold(char c) { return tables.fold[static_cast<uint8_t>(c)]; }
+
+/// Window [begin, end) of the shortest match ending at the first full subsequence match
+struct match_window
+{
+    size_t begin, end;
+    bool found() const { return end > 0; }
+};
+
+static match_window find_window(std::string_view folded, std::string_view pattern)
+{
+    // forward: find the end of the first full subsequence match
+    const char* pos = folded.data();
+    const char* last = pos + folded.size();
+    for (char c : pattern) {
+        pos = static_cast<const char*>(std::memchr(pos, c, last - pos));
+        if (pos == nullptr) return match_window{0, 0};
+        ++pos;
+    }
+    const size_t end = pos - folded.data();
+    // backward: tighten the start of the window
+    size_t begin = end;
+    for (size_t p = pattern.size(); p > 0;) {
+        if (folded[--begin] == pattern[p - 1]) --p;
+    }
+    return match_window{begin, end};
+}
+
+/// Highest score a window can get, whatever the bonuses turn out to be
+static int score_bound(match_window w, size_t pattern_size)
+{
+    const int m = static_cast<int>(pattern_size);
+    const int gaps = static_cast<int>(w.end - w.begin) - m;
+    const int penalty = gaps > 0 ? score_gap_start + (gaps - 1) * score_gap_extension : 0;
+    return score_match * m + bonus_boundary * (bonus_first_char_multiplier + m - 1) + penalty;
+}
+
+static int score_window(std::string_view text, std::string_view folded, std::string_view pattern,
+                        match_window w)
+{
+    const size_t begin = w.begin, end = w.end;
+    size_t p = 0;
+    int score = 0, first_bonus = 0, consecutive = 0;
+    bool in_gap = false;
+    auto prev = begin > 0 ? tables.cls[static_cast<uint8_t>(text[begin - 1])] : non_word;
+    for (size_t i = begin; i < end; ++i) {
+        auto cur = tables.cls[static_cast<uint8_t>(text[i])];
+        if (p < pattern.size() && folded[i] == pattern[p]) {
+            int bonus = bonus_for(prev, cur);
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            } else {
+                if (bonus >= bonus_boundary && bonus > first_bonus) first_bonus = bonus;
+                bonus = std::max({bonus, first_bonus, bonus_consecutive});
+            }
+            score += score_match + (p == 0 ? bonus * bonus_first_char_multiplier : bonus);
+            in_gap = false;
+            ++consecutive;
+            ++p;
+        } else {
+            score += in_gap ? score_gap_extension : score_gap_start;
+            in_gap = true;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        prev = cur;
+    }
+    return score;
+}
+
+int fuzzy_score(std::string_view text, std::string_view folded, std::string_view pattern)
+{
+    if (pattern.empty()) return 0;
+    auto w = find_window(folded, pattern);
+    return w.found() ? score_window(text, folded, pattern, w) : no_match;
+}
+
+/// Higher score first, then earlier line
+static bool better(const fuzzy_match& a, const fuzzy_match& b)
+{
+    return a.score != b.score ? a.score > b.score : a.index < b.index;
+}
+
+fuzzy_matcher::fuzzy_matcher(const std::vector<std::string_view>& lines, unsigned threads)
+    : lines_(lines), threads_(threads ? threads : std::max(1u, std::thread::hardware_concurrency()))
+{
+    size_t size = 0;
+    for (auto line : lines) size += line.size();
+    folded_.reserve(size);
+    starts_.reserve(lines.size());
+    for (auto line : lines) {
+        starts_.push_back(static_cast<uint32_t>(folded_.size()));
+        std::transform(line.begin(), line.end(), std::back_inserter(folded_), fold);
+    }
+    starts_.push_back(static_cast<uint32_t>(folded_.size()));
+}
+
+std::vector<fuzzy_match> fuzzy_matcher::search(std::string_view query, size_t limit)
+{
+    std::string pattern(query.size(), '\0');
+    std::transform(query.begin(), query.end(), pattern.begin(), fold);
+    if (pattern.empty()) {
+        // everything matches equally; nothing to refine from
+        all_ = true;
+        query_.clear();
+        matched_.clear();
+        scored_ = 0;
+        std::vector<fuzzy_match> first(std::min(limit, lines_.size()));
+        for (size_t i = 0; i < first.size(); ++i) {
+            first[i] = fuzzy_match{0, static_cast<uint32_t>(i)};
+        }
+        return first;
+    }
+
+    // a query extending the last one can only match lines that matched before
+    const bool refine = !all_ && pattern.compare(0, query_.size(), query_) == 0;
+    const bool everything = !refine;
+    const size_t count = everything ? lines_.size() : matched_.size();
+    auto candidate = [&](size_t j) {
+        return everything ? static_cast<uint32_t>(j) : matched_[j];
+    };
+
+    // each worker keeps its matches in order and its own bounded heap of the best `limit`
+    struct partial
+    {
+        std::vector<uint32_t> matched;
+        std::vector<fuzzy_match> heap; // worst on top
+    };
+    auto score_range = [&](size_t from, size_t to, partial& out) {
+        for (size_t j = from; j < to; ++j) {
+            const auto i = candidate(j);
+            const std::string_view folded(folded_.data() + starts_[i], starts_[i + 1] - starts_[i]);
+            const auto w = find_window(folded, pattern);
+            if (!w.found()) continue;
+            out.matched.push_back(i);
+            if (out.heap.size() < limit) {
+                out.heap.push_back(fuzzy_match{score_window(lines_[i], folded, pattern, w), i});
+                std::push_heap(out.heap.begin(), out.heap.end(), better);
+                continue;
+            }
+            // candidates come in line order, so an equal score never displaces the worst kept
+            if (limit == 0 || score_bound(w, pattern.size()) <= out.heap.front().score) continue;
+            fuzzy_match m{score_window(lines_[i], folded, pattern, w), i};
+            if (better(m, out.heap.front())) {
+                std::pop_heap(out.heap.begin(), out.heap.end(), better);
+                out.heap.back() = m;
+                std::push_heap(out.heap.begin(), out.heap.end(), better);
+            }
+        }
+    };
+
+    const size_t chunks = std::clamp<size_t>(count / min_chunk_lines, 1, threads_);
+    std::vector<partial> parts(chunks);
+    std::vector<std::thread> workers;
+    for (size_t c = 1; c < chunks; ++c) {
+        workers.emplace_back(
+            [&, c] { score_range(count * c / chunks, count * (c + 1) / chunks, parts[c]); });
+    }
+    score_range(0, count / chunks, parts[0]);
+    for (auto& w : workers) w.join();
+
+    std::vector<uint32_t> matched;
+    std::vector<fuzzy_match> best;
+    if (chunks == 1) {
+        matched = std::move(parts[0].matched);
+        best = std::move(parts[0].heap);
+    } else {
+        for (auto& part : parts) {
+            matched.insert(matched.end(), part.matched.begin(), part.matched.end());
+            best.insert(best.end(), part.heap.begin(), part.heap.end());
+        }
+    }
+    std::sort(best.begin(), best.end(), better);
+    if (best.size() > limit) best.resize(limit);
+
+    scored_ = count;
+    query_ = std::move(pattern);
+    matched_ = std::move(matched);
+    all_ = false;
+    return best;
+}
@@ -0,0 +1,56 @@
+#include "intern.h"
+#include "hash.h"
+#include <algorithm>
+#include <cstring>
+
+constexpr size_t arena_block_size = 16 * 1024;
+
+intern_table::intern_table(size_t capacity, std::pmr::memory_resource* mr)
+    : mr_(mr), ids_(npos, capacity, mr), strings_(mr), blocks_(mr)
+{
+    strings_.reserve(capacity);
+}
+
+intern_table::~intern_table()
+{
+    for (auto [block, size] : blocks_) mr_->deallocate(block, size, 1);
+}
+
+/**
+ * Copy `str` into the arena
+ *
+ * @param str Text to copy
+ *
+ * @return std::string_view View of the arena copy
+ */
+std::string_view intern_table::store(std::string_view str)
+{
+    if (str.size() > remaining_) {
+        size_t n = std::max(arena_block_size, str.size());
+        cursor_ = static_cast<char*>(mr_->allocate(n, 1));
+        blocks_.emplace_back(cursor_, n);
+        remaining_ = n;
+    }
+    std::memcpy(cursor_, str.data(), str.size());
+    std::string_view stored(cursor_, str.size());
+    cursor_ += str.size();
+    remaining_ -= str.size();
+    return stored;
+}
+
+intern_table::id_type intern_table::intern(std::string_view str)
+{
+    const uint64_t hash = hash64(str);
+    auto same = [&](id_type id) { return strings_[id] == str; };
+    if (const id_type* id = ids_.find(hash, same)) return *id;
+    const auto id = static_cast<id_type>(strings_.size());
+    strings_.push_back(store(str));
+    ids_.insert(hash, id);
+    return id;
+}
+
+intern_table::id_type intern_table::find(std::string_view str) const
+{
+    const id_type* id = ids_.find(hash64(str), [&](id_type i) { return strings_[i] == str; });
+    return id == nullptr ? npos : *id;
+}
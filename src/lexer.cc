@@ -0,0 +1,192 @@
+#include "lexer.h"
+#include "task.h"
+#include <array>
+#include <cstring>
+
+namespace {
+    /// Bytes of one class take the same transitions; `_` counts as a letter
+    enum byte_class : uint8_t
+    {
+        other,
+        digit,
+        upper,
+        lower,
+        ex, // `x`, which alone marks a task done
+        dash,
+        colon,
+        slash,
+        at,
+        plus,
+        open,
+        close,
+        n_classes,
+    };
+
+    constexpr std::array<uint8_t, 256> make_classes()
+    {
+        std::array<uint8_t, 256> classes{};
+        for (int c = '0'; c <= '9'; ++c) classes[c] = digit;
+        for (int c = 'A'; c <= 'Z'; ++c) classes[c] = upper;
+        for (int c = 'a'; c <= 'z'; ++c) classes[c] = lower;
+        classes['_'] = lower;
+        classes['x'] = ex;
+        classes['-'] = dash;
+        classes[':'] = colon;
+        classes['/'] = slash;
+        classes['@'] = at;
+        classes['+'] = plus;
+        classes['('] = open;
+        classes[')'] = close;
+        return classes;
+    }
+    constexpr auto classes = make_classes();
+
+    /// DFA states, named after what the word read so far can still become
+    enum state : uint8_t
+    {
+        start,
+        text, // plain word
+        context_sigil,
+        context,
+        project_sigil,
+        project,
+        name,    // [A-Za-z0-9_-]+, a key so far
+        colon_1, // name followed by `:`
+        value,
+        slash_1,
+        slash_2,
+        url,
+        done_x,
+        paren,
+        paren_letter,
+        priority,
+        date_1, // date_1 + k - 1: k characters of YYYY-MM-DD read
+        date_10 = date_1 + 9,
+        n_states,
+    };
+
+    /// States no further byte can leave; the rest of their word is skipped
+    constexpr bool absorbing(uint8_t s)
+    {
+        return s == text || s == context || s == project || s == value || s == url;
+    }
+
+    constexpr bool is_name(uint8_t c)
+    {
+        return c == digit || c == upper || c == lower || c == ex || c == dash;
+    }
+
+    constexpr uint8_t next_state(uint8_t s, uint8_t c)
+    {
+        if (s >= date_1 && s < date_10) {
+            const unsigned read = s - date_1 + 1;
+            if (c == (read == 4 || read == 7 ? dash : digit)) return s + 1;
+        }
+        switch (s) {
+        case start:
+            if (c == digit) return date_1;
+            if (c == ex) return done_x;
+            if (is_name(c)) return name;
+            if (c == at) return context_sigil;
+            if (c == plus) return project_sigil;
+            if (c == open) return paren;
+            return text;
+        case context_sigil:
+        case context:
+            return context;
+        case project_sigil:
+        case project:
+            return project;
+        case colon_1:
+            return c == slash ? slash_1 : value;
+        case value:
+            return value;
+        case slash_1:
+            return c == slash ? slash_2 : text;
+        case slash_2:
+        case url:
+            return url;
+        case paren:
+            return c == upper ? paren_letter : text;
+        case paren_letter:
+            return c == close ? priority : text;
+        case text:
+        case priority:
+            return text;
+        default: // name, done_x and dates all remain valid key names
+            return is_name(c) ? name : c == colon ? colon_1 : text;
+        }
+    }
+
+    constexpr auto make_transitions()
+    {
+        std::array<std::array<uint8_t, n_classes>, n_states> table{};
+        for (uint8_t s = 0; s < n_states; ++s) {
+            for (uint8_t c = 0; c < n_classes; ++c) table[s][c] = next_state(s, c);
+        }
+        return table;
+    }
+    constexpr auto transitions = make_transitions();
+} // namespace
+
+void lex_line(std::string_view line, std::pmr::vector<line_span>& spans)
+{
+    spans.clear();
+    const char* data = line.data();
+    const size_t len = line.size();
+    bool header = true, first = true;
+    int dates = 1; // dates still allowed: completion + creation, or creation only
+    size_t pos = 0;
+    while (pos < len) {
+        while (pos < len && data[pos] == ' ') ++pos;
+        if (pos == len) break;
+        const size_t begin = pos;
+        uint8_t s = start;
+        while (pos < len && data[pos] != ' ') {
+            s = transitions[s][classes[static_cast<unsigned char>(data[pos++])]];
+            if (absorbing(s)) {
+                auto space = static_cast<const char*>(std::memchr(data + pos, ' ', len - pos));
+                pos = space == nullptr ? len : space - data;
+                break;
+            }
+        }
+        auto emit = [&](span_kind kind) {
+            spans.push_back(line_span{static_cast<uint32_t>(begin),
+                                      static_cast<uint32_t>(pos - begin), kind});
+        };
+
+        if (header) {
+            int days;
+            if (first && s == done_x) {
+                emit(span_kind::done);
+                dates = 2;
+            } else if (first && s == priority) {
+                emit(span_kind::priority);
+            } else if (dates > 0 && s == date_10 &&
+                       parse_date(line.substr(begin, pos - begin), days)) {
+                emit(span_kind::date);
+                --dates;
+            } else {
+                header = false;
+            }
+            first = false;
+            if (header) continue;
+        }
+        switch (s) {
+        case context:
+            emit(span_kind::context);
+            break;
+        case project:
+            emit(span_kind::project);
+            break;
+        case value:
+            emit(span_kind::key);
+            break;
+        case url:
+            emit(span_kind::url);
+            break;
+        default:
+            break;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include "log.h"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace alog {
+    namespace detail {
+        constexpr size_t ring_size = 1024; // power of two
+
+        /// Bounded multi-producer ring (Vyukov). Each slot's sequence number says
+        /// whether it is free for the producer at `pos` or ready for the consumer.
+        struct ring
+        {
+            std::array<record, ring_size> records;
+            std::array<std::atomic<size_t>, ring_size> seqs;
+            alignas(64) std::atomic<size_t> enqueue_pos{0};
+            alignas(64) size_t dequeue_pos = 0; // single consumer
+            std::atomic<size_t> dropped{0};
+
+            ring()
+            {
+                for (size_t i = 0; i < ring_size; ++i) seqs[i].store(i, std::memory_order_relaxed);
+            }
+        };
+
+        static ring g_ring;
+        static std::thread g_writer;
+        static std::atomic<bool> g_running{false};
+        static std::once_flag g_started;
+        static const int64_t g_start_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+
+        static void writer_loop();
+
+        record* acquire()
+        {
+            size_t pos = g_ring.enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                size_t seq = g_ring.seqs[pos & (ring_size - 1)].load(std::memory_order_acquire);
+                auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+                if (diff == 0) {
+                    if (g_ring.enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                                 std::memory_order_relaxed)) {
+                        return &g_ring.records[pos & (ring_size - 1)];
+                    }
+                } else if (diff < 0) {
+                    g_ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                } else {
+                    pos = g_ring.enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void commit(record* rec)
+        {
+            size_t i = static_cast<size_t>(rec - g_ring.records.data());
+            // producer that acquired slot i at position pos saw seq == pos; publish pos + 1
+            size_t seq = g_ring.seqs[i].load(std::memory_order_relaxed);
+            g_ring.seqs[i].store(seq + 1, std::memory_order_release);
+            std::call_once(g_started, [] {
+                g_running.store(true, std::memory_order_release);
+                g_writer = std::thread(writer_loop);
+                std::atexit(stop);
+            });
+        }
+
+        /// Format and write one record in a loguru-like layout
+        static void write(const record& rec, fmt::memory_buffer& buf)
+        {
+            buf.clear();
+            std::string_view file(rec.file);
+            if (auto slash = file.rfind('/'); slash != std::string_view::npos) {
+                file.remove_prefix(slash + 1);
+            }
+            const char* level = rec.verbosity == loguru::Verbosity_ERROR     ? "ERR"
+                                : rec.verbosity == loguru::Verbosity_WARNING ? "WARN"
+                                                                               : nullptr;
+            auto uptime = static_cast<double>(rec.time_ns - g_start_ns) / 1e9;
+            if (level) {
+                fmt::format_to(std::back_inserter(buf), "({:8.3f}s) {:>16}:{:<5}{:>4}| ", uptime,
+                               file, rec.line, level);
+            } else {
+                fmt::format_to(std::back_inserter(buf), "({:8.3f}s) {:>16}:{:<5}{:>4}| ", uptime,
+                               file, rec.line, rec.verbosity);
+            }
+            rec.decode(rec, buf);
+            buf.push_back('\n');
+            std::fwrite(buf.data(), 1, buf.size(), stderr);
+        }
+
+        /// Write all published records; returns number written
+        static size_t drain(fmt::memory_buffer& buf)
+        {
+            size_t n = 0;
+            for (;;) {
+                size_t pos = g_ring.dequeue_pos;
+                size_t i = pos & (ring_size - 1);
+                if (g_ring.seqs[i].load(std::memory_order_acquire) != pos + 1) break;
+                write(g_ring.records[i], buf);
+                g_ring.seqs[i].store(pos + ring_size, std::memory_order_release);
+                g_ring.dequeue_pos = pos + 1;
+                ++n;
+            }
+            return n;
+        }
+
+        static void writer_loop()
+        {
+            fmt::memory_buffer buf;
+            while (g_running.load(std::memory_order_acquire)) {
+                if (drain(buf) == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                } else {
+                    std::fflush(stderr);
+                }
+            }
+        }
+    } // namespace detail
+
+    void set_verbosity(int verbosity)
+    {
+        detail::g_verbosity.store(verbosity, std::memory_order_relaxed);
+    }
+
+    void stop()
+    {
+        if (detail::g_running.exchange(false)) detail::g_writer.join();
+        fmt::memory_buffer buf;
+        detail::drain(buf);
+        if (auto dropped = detail::g_ring.dropped.exchange(0); dropped > 0) {
+            std::fprintf(stderr, "alog: dropped %zu log records (ring full)\n", dropped);
+        }
+        std::fflush(stderr);
+    }
+} // namespace alog
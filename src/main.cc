@@ -1,21 +1,39 @@
 #define LOGURU_USE_FMTLIB 1
 #define OPTPARSE_IMPLEMENTATION
 #define OPTPARSE_API static
+#include "arena.h"
 #include "common.h"
+#include "complete.h"
 #include "config.h"
+#include "dedupe.h"
+#include "format.h"
+#include "fuzzy.h"
+#include "log.h"
+#include "merge.h"
 #include "optparse.h"
+#include "search.h"
+#include "snapshot.h"
+#include "stats.h"
+#include "task.h"
+#include "task_id.h"
+#include "width.h"
 #include <CLI/CLI.hpp>
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <ext/alloc_traits.h>
 #include <filesystem>
 #include <fmt/core.h>
+#include <fmt/format.h>
 #include <fmt/ostream.h> // IWYU pragma: keep
 #include <fstream>       // IWYU pragma: keep
 #include <iostream>
+#include <iterator>
 /* #include <loguru/loguru.hpp> */
 #include <loguru.hpp>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -23,6 +41,9 @@
 
 constexpr bool DEBUG_MODE = false; // More verbose console logging
 
+/// Smaller files are scanned directly; building and caching indexes does not pay off
+constexpr size_t min_indexed_size = 1 << 20;
+
 /**
  * Initialize loguru with command line args
  *
@@ -44,7 +65,6 @@ void init_loguru(int& argc, char** argv)
 {
     loguru::g_stderr_verbosity = -2;
     loguru::g_colorlogtostderr = true;
-    loguru::g_flush_interval_ms = 100;
     auto tsize = getTermSize();
     if (tsize->cols < 200) {
         loguru::g_preamble_thread = false;
@@ -55,6 +75,7 @@ void init_loguru(int& argc, char** argv)
         }
     }
     loguru::init(argc, argv);
+    alog::set_verbosity(loguru::g_stderr_verbosity);
     VLOG_F(1, "Terminal size: {}x{}", tsize->cols, tsize->lines);
 }
 
@@ -70,111 +91,132 @@ std::filesystem::path get_todo_file_path()
     // TODO: check env vars
     std::filesystem::path fpath(getenv("HOME"));
     fpath.append("Dropbox").append("todo").append("todo.txt");
-    LOG_F(INFO, "Todo file path: {}", fpath.c_str());
+    ALOG_F(INFO, "Todo file path: {}", fpath.c_str());
     return fpath;
 }
 
 /**
- * Get entire file as a vec of strings
+ * Get entire file as a string, read from a consistent snapshot of it.
+ * If the file is rewritten in place while being read, it is read again.
  *
  * @param fpath Path to file
+ * @param mr Memory resource backing the result
+ * @param stamp Set to the stamp of the contents read, if not `nullptr`
  *
- * @return std::string File contents
+ * @return std::pmr::string File contents
  */
-std::string get_file_contents(std::filesystem::path fpath)
+std::pmr::string get_file_contents(std::filesystem::path fpath, std::pmr::memory_resource* mr,
+                                   file_stamp* stamp = nullptr)
 {
-    std::ifstream file{fpath};
-    CHECK_F(file.is_open(), "Failed to open file '{}'", fpath.c_str());
-    const auto fsize = std::filesystem::file_size(fpath);
-    std::string result(fsize, ' ');
-    file.read(result.data(), fsize);
-    return result;
+    while (true) {
+        auto snapshot = file_snapshot::open(fpath);
+        CHECK_F(snapshot != nullptr, "Failed to open file '{}'", fpath.c_str());
+        std::pmr::string result(snapshot->stamp().size, '\0', mr);
+        if (snapshot->read(result.data()) && snapshot->intact()) {
+            if (stamp != nullptr) *stamp = snapshot->stamp();
+            return result;
+        }
+        ALOG_F(WARNING, "File '{}' changed while reading; reading again", fpath.c_str());
+    }
+}
+
+/**
+ * Check that the todo file exists, telling the user if not
+ *
+ * @param fpath Path to file
+ *
+ * @return bool Whether `fpath` is a regular file
+ */
+bool check_todo_file(const std::filesystem::path& fpath)
+{
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(fpath, ec)) return true;
+    fmt::print(stderr, "Cannot read {}\n", fpath.c_str());
+    return false;
 }
 
 /**
  * Get entire file as a vec of strings
  *
  * @param fpath Path to file
+ * @param mr Memory resource backing the result
  *
- * @return std::vector<std::string> File lines
+ * @return std::pmr::vector<std::pmr::string> File lines
  */
-std::vector<std::string> get_file_lines(std::filesystem::path fpath)
+std::pmr::vector<std::pmr::string> get_file_lines(std::filesystem::path fpath,
+                                                  std::pmr::memory_resource* mr)
 {
     std::ifstream file{fpath};
     CHECK_F(file.is_open(), "Failed to open file '{}'", fpath.c_str());
-    std::vector<std::string> result;
+    std::pmr::vector<std::pmr::string> result(mr);
     std::string line;
     line.reserve(256);
     while (getline(file, line)) {
-        result.emplace_back(line);
+        result.emplace_back(line.data(), line.size());
     }
     file.close();
     return result;
 }
 
 /**
- * Get a container of tokens from string
+ * Split buffer into non-empty lines without copying
  *
- * @param str String view (read-only) to tokenize
- * @param tokens Container ref to fill
- * @param delimiters Split by this string (default: " ")
- * @param trimEmptyfalse Trim empty lines
+ * @param raw Buffer to split
+ * @param mr Memory resource backing the result
+ * @param numbers Set to the task number of each line, if not `nullptr`: its 1-based
+ *        line number in `raw`, counting the blank lines skipped, as todo.sh does
  *
- * @return void
+ * @return std::pmr::vector<std::string_view> Views into `raw`
  */
-template <typename ContainerT>
-void tokenize(std::string_view str, ContainerT& tokens, std::string_view delimiters = " ",
-              bool trimEmpty = false)
+std::pmr::vector<std::string_view> split_lines(std::string_view raw, std::pmr::memory_resource* mr,
+                                               std::pmr::vector<uint32_t>* numbers = nullptr)
 {
-    std::string::size_type pos, lastPos = 0, length = str.length();
-
-    using value_type = typename ContainerT::value_type;
-    using size_type = typename ContainerT::size_type;
-
-    while (lastPos < length + 1) {
-        pos = str.find_first_of(delimiters, lastPos);
-        if (pos == std::string::npos) {
-            pos = length;
-        }
-
-        if (pos != lastPos || !trimEmpty)
-            tokens.push_back(value_type(str.data() + lastPos, (size_type)pos - lastPos));
-
-        lastPos = pos + 1;
-    }
+    std::pmr::vector<std::string_view> lines(mr);
+    const size_t count = std::count(raw.begin(), raw.end(), '\n') + 1;
+    lines.reserve(count);
+    if (numbers != nullptr) numbers->reserve(count);
+    uint32_t number = 0;
+    for_each_line(raw, [&](std::string_view line) {
+        ++number;
+        if (line.empty()) return;
+        lines.push_back(line);
+        if (numbers != nullptr) numbers->push_back(number);
+    });
+    return lines;
 }
 
 /**
- * Format lines of todo.txt file
+ * Look up lines matching plain search words through the trigram index.
+ * The index is mapped from its cache when it is current; otherwise it is
+ * rebuilt and saved. Only worth it for files of `min_indexed_size` or more.
  *
- * @param lines
+ * @param fpath Path to file `raw` was read from
+ * @param stamp Stamp of the contents read into `raw`
+ * @param raw File contents
+ * @param words Search words (not contexts or projects)
+ * @param mr Memory resource backing the result
  *
- * @return std::string Formatted lines joined together
+ * @return std::pmr::vector<std::string_view> Matching lines, in file order
  */
-std::string format_lines(std::vector<std::string>& lines)
+std::pmr::vector<std::string_view> search_lines(const std::filesystem::path& fpath,
+                                                const file_stamp& stamp, std::string_view raw,
+                                                const std::vector<std::string_view>& words,
+                                                std::pmr::memory_resource* mr)
 {
-    std::string out;
-    for (size_t i = 0; i < lines.size(); ++i) {
-        std::vector<std::string> words;
-        tokenize(lines[i], words, " ", true);
-        if (i > 0) out.push_back('\n');
-        for (auto& word : words) {
-            switch (word.at(0)) {
-            case '@':
-                out.append(fmt::format("{}{}{}", Ansi::setFg(Ansi::Color::lightorange), word,
-                                       Ansi::reset()));
-                break;
-            case '+':
-                out.append(
-                    fmt::format("{}{}{}", Ansi::setFg(Ansi::Color::lime), word, Ansi::reset()));
-                break;
-            default:
-                out.append(word);
-            }
-            out.push_back(' ');
-        }
+    const auto index_path = cache_path(fpath, "trigram");
+    trigram_index index;
+    if (index.load(index_path, stamp)) {
+        VALOG_F(1, "Loaded trigram index of {} lines", index.size());
+    } else {
+        index.build(raw);
+        if (file_stamp::of(fpath) == stamp) index.save(index_path, stamp);
+        VALOG_F(1, "Built trigram index of {} lines", index.size());
     }
-    return out;
+    std::pmr::vector<std::string_view> lines(mr);
+    auto found = index.find(raw, words);
+    lines.reserve(found.size());
+    for (auto i : found) lines.push_back(index.line(raw, i));
+    return lines;
 }
 
 // std::string get_help() {
@@ -194,7 +236,7 @@ void chomp_trailing_char(std::string& str, const char ch)
         str.resize(len - 1);
         return;
     }
-    LOG_F(INFO, "Trailing character of string did not match '{}'", ch);
+    ALOG_F(INFO, "Trailing character of string did not match '{}'", ch);
     return;
 }
 
@@ -213,8 +255,20 @@ int parse_opts(char** argv, std::shared_ptr<options> opts)
     struct optparse options;
     optparse_init(&options, argv);
 
-    while ((opt = optparse(&options, "hVqgv:")) != -1) {
-        LOG_F(3, "Opt index {}: {}", options.optind, char(options.optopt));
+    struct optparse_long longopts[] = {{"help", 'h', OPTPARSE_NONE},
+                                       {"version", 'V', OPTPARSE_NONE},
+                                       {"quiet", 'q', OPTPARSE_NONE},
+                                       {"getline", 'g', OPTPARSE_NONE},
+                                       {"verbosity", 'v', OPTPARSE_REQUIRED},
+                                       {"wrap", 'w', OPTPARSE_NONE},
+                                       {"truncate", 't', OPTPARSE_NONE},
+                                       {"limit", 'n', OPTPARSE_REQUIRED},
+                                       {"ids", 'i', OPTPARSE_NONE},
+                                       {"dupes", 'd', OPTPARSE_REQUIRED},
+                                       {0, 0, OPTPARSE_NONE}};
+
+    while ((opt = optparse_long(&options, longopts, nullptr)) != -1) {
+        ALOG_F(3, "Opt index {}: {}", options.optind, char(options.optopt));
         switch (opt) {
         case 'h':
             fmt::print("Usage: {}\n", argv[0]);
@@ -222,35 +276,62 @@ int parse_opts(char** argv, std::shared_ptr<options> opts)
         case 'q':
             opts->quiet = true;
             break;
+        case 'g':
+            opts->getline = true;
+            break;
+        case 'w':
+            opts->overflow = overflow_mode::wrap;
+            break;
+        case 't':
+            opts->overflow = overflow_mode::truncate;
+            break;
+        case 'n':
+            opts->limit = std::strtoul(options.optarg, nullptr, 10);
+            break;
+        case 'i':
+            opts->ids = true;
+            break;
+        case 'd':
+            if (std::string_view mode = options.optarg; mode == "allow") {
+                opts->dupes = dupe_mode::allow;
+            } else if (mode == "flag") {
+                opts->dupes = dupe_mode::flag;
+            } else if (mode == "reject") {
+                opts->dupes = dupe_mode::reject;
+            } else {
+                ALOG_F(WARNING, "Unknown duplicate mode '{}'", mode);
+            }
+            break;
         case ':':
-            LOG_F(WARNING, "Option '{}' requires an argument", options.optopt);
+            ALOG_F(WARNING, "Option '{}' requires an argument", options.optopt);
             break;
         case 'v':
             opts->verbosity = options.optarg;
             break;
         case 'V':
-            LOG_F(INFO, "Found version flag");
+            ALOG_F(INFO, "Found version flag");
             break;
         case '?':
-            LOG_F(WARNING, "Unknown option '{}'", char(options.optopt));
+            ALOG_F(WARNING, "Unknown option '{}'", char(options.optopt));
             break;
         default:
-            LOG_F(1, "Found: {}", options.optarg);
+            ALOG_F(1, "Found: {}", options.optarg);
         }
     }
 
-    std::vector<std::string> cmds{"add", "list"};
-    if (LOG_IS_ON(2)) {
-        LOG_SCOPE_F(2, "Argv after parsing:");
-        auto i = 0;
-        while ((arg = optparse_arg(&options))) {
-            LOG_F(2, "{}: {}", i, arg);
-            if (std::find(cmds.begin(), cmds.end(), arg) != cmds.end()) {
-                LOG_F(2, "--> Found command '{}'", arg);
-                opts->cmd = arg;
-            }
-            ++i;
+    std::vector<std::string> cmds{"add",  "complete", "dedupe", "do",
+                                  "list", "merge",    "pick",   "stats"};
+    ALOG_F(2, "Argv after parsing:");
+    auto i = 0;
+    while ((arg = optparse_arg(&options))) {
+        ALOG_F(2, "{}: {}", i, arg);
+        if (opts->cmd.empty() && std::find(cmds.begin(), cmds.end(), arg) != cmds.end()) {
+            ALOG_F(2, "--> Found command '{}'", arg);
+            opts->cmd = arg;
+        } else if (!opts->cmd.empty()) {
+            opts->args.emplace_back(arg);
         }
+        ++i;
     }
     // if (LOG_IS_ON(2) && argc > 0) {
     //     LOG_SCOPE_F(2, "Argv after parsing:");
@@ -265,6 +346,354 @@ int parse_opts(char** argv, std::shared_ptr<options> opts)
     return 0;
 }
 
+/**
+ * Print statistics of todo.txt and done.txt
+ *
+ * @param fpath Path to todo.txt; done.txt is expected next to it
+ *
+ * @return int Exit status
+ */
+int print_stats(const std::filesystem::path& fpath)
+{
+    const int today = current_day();
+    // read with pread rather than scanning the mapping, which faults if the file is
+    // truncated in place; `contents` stays empty if there is no such file
+    auto scan = [&](const std::filesystem::path& path, std::string& contents, task_stats& st) {
+        while (true) {
+            auto snapshot = file_snapshot::open(path);
+            if (snapshot == nullptr) return false;
+            contents.assign(snapshot->stamp().size, '\0');
+            if (snapshot->read(contents.data()) && snapshot->intact()) {
+                st = collect_stats(contents, today);
+                return true;
+            }
+            ALOG_F(WARNING, "File '{}' changed while reading; reading again", path.c_str());
+        }
+    };
+    std::string todo_text, done_text;
+    task_stats todo, done;
+    if (!scan(fpath, todo_text, todo)) {
+        fmt::print(stderr, "Cannot read {}\n", fpath.c_str());
+        return 1;
+    }
+    scan(fpath.parent_path() / "done.txt", done_text, done); // may not exist
+    VALOG_F(1, "Scanned {} + {} bytes", todo_text.size(), done_text.size());
+    std::cout << format_stats(todo, done); // tags view into the contents
+    return 0;
+}
+
+/**
+ * Print tags starting with `prefix`, most used first, one per line.
+ * Answered from the cached tag index when it is current, without reading
+ * the todo file; otherwise the file is parsed and the index rebuilt.
+ *
+ * @param fpath Path to todo.txt
+ * @param prefix Start of a context, project or key (e.g. `@wo`, `+`, `du`)
+ *
+ * @return int Exit status
+ */
+int complete_tags(const std::filesystem::path& fpath, std::string_view prefix)
+{
+    if (!check_todo_file(fpath)) return 1;
+    const auto stamp = file_stamp::of(fpath);
+    const auto index_path = cache_path(fpath, "tags");
+    tag_index index;
+    if (!index.load(index_path, stamp)) {
+        const auto raw = get_file_contents(fpath, std::pmr::get_default_resource());
+        arena pool(arena_size_for(raw.size(), std::count(raw.begin(), raw.end(), '\n') + 1));
+        auto mr = pool.resource();
+        intern_table tags(256, mr);
+        auto tasks = parse_lines(split_lines(raw, mr), tags, mr);
+        std::vector<uint32_t> counts(tags.size());
+        for (const auto& t : tasks) {
+            for (auto tag : t.tags) ++counts[tag.id];
+        }
+        index.build(tags, counts);
+        if (raw.size() >= min_indexed_size && file_stamp::of(fpath) == stamp) {
+            index.save(index_path, stamp);
+        }
+    }
+    std::string out;
+    for (const auto& match : index.complete(prefix)) out.append(match.first).push_back('\n');
+    std::cout << out;
+    VALOG_F(1, "Completed '{}' from {} tags", prefix, index.size());
+    return 0;
+}
+
+/**
+ * Three-way merge Dropbox conflicted copies of todo.txt into it.
+ * The base is the last version both sides shared (see `write_todo_file`).
+ * Without one, every region where the copies differ is a conflict. If any region
+ * conflicts, the conflicts are printed and no file is touched.
+ *
+ * @param fpath Path to todo.txt
+ *
+ * @return int Exit status; 1 if there were conflicts
+ */
+int merge_copies(const std::filesystem::path& fpath)
+{
+    const auto copies = conflicted_copies(fpath);
+    if (copies.empty()) {
+        fmt::print("No conflicted copies of {}\n", fpath.filename().string());
+        return 0;
+    }
+    file_lock lock(fpath);
+    CHECK_F(lock.locked(), "Failed to lock '{}'", fpath.c_str());
+    const auto base_path = merge_base_path(fpath);
+    const bool has_base = std::filesystem::exists(base_path);
+    size_t size = std::filesystem::file_size(fpath);
+    if (has_base) size += std::filesystem::file_size(base_path);
+    for (const auto& copy : copies) size += std::filesystem::file_size(copy);
+    arena pool(size + 4096);
+    auto mr = pool.resource();
+
+    std::pmr::string base_raw(mr);
+    if (has_base) base_raw = get_file_contents(base_path, mr);
+    const auto base = split_all_lines(base_raw);
+    const auto ours_raw = get_file_contents(fpath, mr);
+    auto merged = split_all_lines(ours_raw);
+    std::vector<std::pmr::string> copy_raws;
+    copy_raws.reserve(copies.size());
+    size_t conflicts = 0;
+    for (const auto& copy : copies) {
+        copy_raws.push_back(get_file_contents(copy, mr));
+        const auto theirs = split_all_lines(copy_raws.back());
+        auto result = has_base ? merge3(base, merged, theirs) : merge2(merged, theirs);
+        VALOG_F(1, "Merged {} ({} lines): {} conflicts", copy.filename().c_str(), theirs.size(),
+                result.conflicts.size());
+        for (const auto& c : result.conflicts) {
+            std::string out;
+            auto it = std::back_inserter(out);
+            fmt::format_to(it, "Conflict at line {} of {}:\n<<<<<<< {}\n", c.base_line + 1,
+                           has_base ? "base" : fpath.filename().string(),
+                           fpath.filename().string());
+            for (auto line : c.ours) fmt::format_to(it, "{}\n", line);
+            if (has_base) {
+                fmt::format_to(it, "||||||| base\n");
+                for (auto line : c.base) fmt::format_to(it, "{}\n", line);
+            }
+            fmt::format_to(it, "=======\n");
+            for (auto line : c.theirs) fmt::format_to(it, "{}\n", line);
+            fmt::format_to(it, ">>>>>>> {}\n", copy.filename().string());
+            std::cout << out;
+        }
+        conflicts += result.conflicts.size();
+        merged = std::move(result.lines);
+    }
+    if (conflicts > 0) {
+        fmt::print("{} conflicts; nothing was written\n", conflicts);
+        return 1;
+    }
+
+    std::string text;
+    text.reserve(ours_raw.size());
+    for (auto line : merged) text.append(line).push_back('\n');
+    CHECK_F(write_merged_file(fpath, text), "Failed to write '{}'", fpath.c_str());
+    for (const auto& copy : copies) std::filesystem::remove(copy);
+    fmt::print("Merged {} conflicted copies into {}\n", copies.size(), fpath.filename().string());
+    return 0;
+}
+
+/**
+ * Mark tasks done, as todo.sh does: prepend `x` and today's date and drop
+ * the priority. Tasks are named by stable id or by task number.
+ *
+ * @param fpath Path to todo.txt
+ * @param args Ids or 1-based task numbers
+ *
+ * @return int Exit status; 1 if any argument names no task
+ */
+int do_tasks(const std::filesystem::path& fpath, const std::vector<std::string>& args)
+{
+    if (args.empty()) {
+        fmt::print(stderr, "Usage: ctodo do <number|id>...\n");
+        return 1;
+    }
+    if (!check_todo_file(fpath)) return 1;
+    file_lock lock(fpath);
+    CHECK_F(lock.locked(), "Failed to lock '{}'", fpath.c_str());
+    file_stamp stamp;
+    const auto raw = get_file_contents(fpath, std::pmr::get_default_resource(), &stamp);
+    arena pool(arena_size_for(raw.size(), std::count(raw.begin(), raw.end(), '\n') + 1));
+    auto mr = pool.resource();
+    std::pmr::vector<uint32_t> numbers(mr);
+    const auto lines = split_lines(raw, mr, &numbers);
+    const task_ids ids(lines, mr);
+
+    std::vector<size_t> targets;
+    for (const auto& arg : args) {
+        const auto i = ids.resolve(arg, numbers);
+        if (i == task_ids::npos) {
+            fmt::print(stderr, "No task '{}'\n", arg);
+            return 1;
+        }
+        targets.push_back(i);
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+
+    const auto today = format_date(current_day());
+    std::vector<std::string> done;
+    std::vector<std::string_view> pieces;
+    done.reserve(targets.size()); // `pieces` views into these
+    const char* pos = raw.data();
+    for (auto i : targets) {
+        const auto line = lines[i];
+        const auto header = parse_header(line);
+        if (header.done) {
+            fmt::print("{} is already done: {}\n", task_ids::format(ids.id(i)), line);
+            continue;
+        }
+        auto rest = header.priority ? line.substr(line.find(')') + 1) : line;
+        rest.remove_prefix(std::min(rest.find_first_not_of(' '), rest.size()));
+        done.push_back(fmt::format("x {} {}", today, rest));
+        pieces.emplace_back(pos, line.data() - pos);
+        pieces.emplace_back(done.back());
+        pos = line.data() + line.size();
+        fmt::print("{} {}\n", task_ids::format(ids.id(i)), done.back());
+    }
+    if (done.empty()) return 0;
+    pieces.emplace_back(pos, raw.data() + raw.size() - pos);
+    CHECK_F(write_todo_file(fpath, stamp, raw, pieces), "Failed to write '{}'", fpath.c_str());
+    return 0;
+}
+
+/**
+ * Append a task to todo.txt. Unless duplicates are allowed, the task's
+ * fingerprint is first looked up among those of every line already in the
+ * file, which are loaded from a cache next to it or hashed in one pass.
+ * Runs under the writer lock, so concurrent adds are never lost.
+ *
+ * @param fpath Path to todo.txt
+ * @param args Words of the task
+ * @param dupes What to do if the task is already listed
+ *
+ * @return int Exit status; 1 if the task was rejected
+ */
+int add_task(const std::filesystem::path& fpath, const std::vector<std::string>& args,
+             dupe_mode dupes)
+{
+    std::string line;
+    for (const auto& arg : args) {
+        if (!line.empty()) line.push_back(' ');
+        line.append(arg);
+    }
+    if (line.find_first_not_of(" \t") == std::string::npos) {
+        fmt::print(stderr, "Usage: ctodo add <task>\n");
+        return 1;
+    }
+    std::string scratch;
+    const auto print = line_fingerprint(line, scratch);
+
+    file_lock lock(fpath);
+    CHECK_F(lock.locked(), "Failed to lock '{}'", fpath.c_str());
+    // like todo.sh, adding to a missing todo.txt creates it
+    std::error_code missing;
+    const auto size = std::filesystem::file_size(fpath, missing);
+    arena pool(missing ? 4096 : size + 4096);
+    file_stamp stamp{0, 0, 0};
+    std::pmr::string raw(pool.resource());
+    if (!missing) raw = get_file_contents(fpath, pool.resource(), &stamp);
+    const auto index_path = cache_path(fpath, "lines");
+    const bool indexed = stamp.size >= min_indexed_size;
+    fingerprint_set prints;
+    if (dupes != dupe_mode::allow) {
+        if (!prints.load(index_path, stamp)) {
+            prints = fingerprint_set::of(raw);
+            if (indexed) prints.save(index_path, stamp);
+        }
+        if (prints.contains(print)) {
+            if (dupes == dupe_mode::reject) {
+                fmt::print(stderr, "Already listed: {}\n", line);
+                return 1;
+            }
+            fmt::print(stderr, "Adding duplicate: {}\n", line);
+        }
+    }
+
+    const bool ends_in_newline = raw.empty() || raw.back() == '\n';
+    CHECK_F(write_todo_file(fpath, stamp, raw, {raw, ends_in_newline ? "" : "\n", line, "\n"}),
+            "Failed to write '{}'", fpath.c_str());
+    fmt::print("{}\n", line);
+    // keep a current cache current, so the next check skips hashing the file
+    if (dupes != dupe_mode::allow && indexed) {
+        prints.insert(print);
+        prints.save(index_path, file_stamp::of(fpath));
+    }
+    return 0;
+}
+
+/**
+ * Remove duplicate tasks from todo.txt, keeping the first of each.
+ * Lines are duplicates if they differ only in case and spacing.
+ *
+ * @param fpath Path to todo.txt
+ *
+ * @return int Exit status
+ */
+int dedupe_tasks(const std::filesystem::path& fpath)
+{
+    if (!check_todo_file(fpath)) return 1;
+    file_lock lock(fpath);
+    CHECK_F(lock.locked(), "Failed to lock '{}'", fpath.c_str());
+    arena pool(std::filesystem::file_size(fpath) + 4096);
+    file_stamp stamp;
+    const auto raw = get_file_contents(fpath, pool.resource(), &stamp);
+    std::vector<std::string_view> removed;
+    const auto kept = dedupe_lines(raw, removed);
+    if (removed.empty()) {
+        fmt::print("No duplicates in {}\n", fpath.filename().string());
+        return 0;
+    }
+    CHECK_F(write_todo_file(fpath, stamp, raw, {kept}), "Failed to write '{}'", fpath.c_str());
+    std::string out;
+    for (auto line : removed) fmt::format_to(std::back_inserter(out), "Removed: {}\n", line);
+    std::cout << out;
+    fmt::print("Removed {} duplicates from {}\n", removed.size(), fpath.filename().string());
+    return 0;
+}
+
+/**
+ * Interactive fuzzy picker for editor plugins.
+ * Each line read from stdin is the current query; the best matches are
+ * written as `<task number>\t<text>` lines followed by an empty line.
+ *
+ * @param fpath Path to todo.txt
+ * @param limit Results per query
+ * @param show_ids Name matches by stable id instead of task number
+ *
+ * @return int Exit status
+ */
+int pick_tasks(const std::filesystem::path& fpath, size_t limit, bool show_ids)
+{
+    if (!check_todo_file(fpath)) return 1;
+    arena pool(std::filesystem::file_size(fpath) + 4096);
+    auto raw = get_file_contents(fpath, pool.resource());
+    std::pmr::vector<uint32_t> numbers(pool.resource());
+    auto views = split_lines(raw, pool.resource(), &numbers);
+    const std::vector<std::string_view> lines(views.begin(), views.end());
+    std::unique_ptr<task_ids> ids;
+    if (show_ids) ids = std::make_unique<task_ids>(views);
+    fuzzy_matcher matcher(lines);
+
+    std::string query, out;
+    while (std::getline(std::cin, query)) {
+        const auto start = std::chrono::steady_clock::now();
+        out.clear();
+        for (const auto& m : matcher.search(query, limit)) {
+            auto name = ids ? task_ids::format(ids->id(m.index)) : std::to_string(numbers[m.index]);
+            fmt::format_to(std::back_inserter(out), "{}\t{}\n", name, lines[m.index]);
+        }
+        out.push_back('\n');
+        std::cout << out << std::flush;
+        VALOG_F(1, "Query '{}': scored {} lines in {} us", query, matcher.scored(),
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count());
+    }
+    return 0;
+}
+
 /**
  * Parse command-line arguments and commands.
  *
@@ -351,20 +780,71 @@ int main(int argc, char** argv)
     }
 
     // loguru::g_stderr_verbosity = loguru::get_verbosity_from_name(opts->verbosity.data());
-    if (opts->quiet) loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+    if (opts->quiet) {
+        loguru::g_stderr_verbosity = loguru::Verbosity_OFF;
+        alog::set_verbosity(loguru::Verbosity_OFF);
+    }
     LOG_F(2, "{}", opts);
     auto fpath = get_todo_file_path();
+    if (opts->cmd == "stats") return print_stats(fpath);
+    if (opts->cmd == "pick") return pick_tasks(fpath, opts->limit, opts->ids);
+    if (opts->cmd == "add") return add_task(fpath, opts->args, opts->dupes);
+    if (opts->cmd == "dedupe") return dedupe_tasks(fpath);
+    if (opts->cmd == "do") return do_tasks(fpath, opts->args);
+    if (opts->cmd == "merge") return merge_copies(fpath);
+    if (opts->cmd == "complete") {
+        return complete_tags(fpath, opts->args.empty() ? "" : opts->args[0]);
+    }
+    // The file is read before the arena is made, so it can be sized by lines as well as
+    // bytes; everything after is allocated from the arena, released at exit
+    std::pmr::string raw;
+    std::pmr::vector<std::pmr::string> raw_lines;
+    file_stamp stamp{0, 0, 0};
+    size_t bytes = 0, line_count = 0;
+    if (opts->getline) {
+        ALOG_F(INFO, "Reading file lines into vector");
+        raw_lines = get_file_lines(fpath, std::pmr::get_default_resource());
+        for (const auto& line : raw_lines) bytes += line.size() + 1;
+        line_count = raw_lines.size();
+    } else {
+        ALOG_F(INFO, "Reading contents of file into string");
+        raw = get_file_contents(fpath, std::pmr::get_default_resource(), &stamp);
+        bytes = raw.size();
+        line_count = std::count(raw.begin(), raw.end(), '\n') + 1;
+    }
+    arena pool(arena_size_for(bytes, line_count));
+    auto mr = pool.resource();
+    std::pmr::vector<std::string_view> lines(mr);
     if (opts->getline) {
-        LOG_F(INFO, "Reading file lines into vector");
-        auto lines = get_file_lines(fpath);
-        std::string out(format_lines(lines));
-        std::cout << out << std::endl;
+        lines.assign(raw_lines.begin(), raw_lines.end());
     } else {
-        LOG_F(INFO, "Reading contents of file into string");
-        std::string raw(get_file_contents(fpath));
-        std::vector<std::string> lines;
-        tokenize(raw, lines, "\n", true);
-        std::string out(format_lines(lines));
-        std::cout << out << std::endl;
+        std::vector<std::string_view> words;
+        if (opts->cmd == "list") {
+            for (const auto& term : opts->args) {
+                std::string_view interned;
+                auto kind = classify_word(term, interned);
+                if (kind != tag_kind::context && kind != tag_kind::project) words.push_back(term);
+            }
+        }
+        // ids depend on every line of the file, so they rule out the index; below
+        // `min_indexed_size`, filter_tasks scanning every line is faster than building it
+        lines = words.empty() || opts->ids || raw.size() < min_indexed_size
+                    ? split_lines(raw, mr)
+                    : search_lines(fpath, stamp, raw, words, mr);
+    }
+    const auto paint = palette::current();
+    const size_t cols = getTermSize()->cols;
+    const auto allocs_before = global_allocations();
+    intern_table tags(256, mr);
+    auto tasks = parse_lines(lines, tags, mr);
+    if (opts->ids) {
+        const task_ids ids(lines, mr);
+        for (size_t i = 0; i < tasks.size(); ++i) tasks[i].id = ids.id(i);
     }
+    if (opts->cmd == "list") filter_tasks(tasks, opts->args, tags);
+    auto out = format_lines(tasks, paint, mr, opts->overflow, cols, opts->ids);
+    VALOG_F(1, "Arena: {} bytes reserved, {} overflow allocations, {} malloc calls in pipeline",
+            pool.reserved_bytes(), pool.overflow_allocations(),
+            global_allocations() - allocs_before);
+    std::cout << out << std::endl;
 }
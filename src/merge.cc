@@ -0,0 +1,320 @@
+#include "merge.h"
+#include "hash.h"
+#include "hash_map.h"
+#include "log.h"
+#include "task.h"
+#include <algorithm>
+
+std::vector<std::string_view> split_all_lines(std::string_view buffer)
+{
+    std::vector<std::string_view> lines;
+    for_each_line(buffer, [&](std::string_view line) { lines.push_back(line); });
+    return lines;
+}
+
+std::vector<uint64_t> fingerprint_lines(const std::vector<std::string_view>& lines)
+{
+    std::vector<uint64_t> prints(lines.size());
+    std::transform(lines.begin(), lines.end(), prints.begin(),
+                   [](std::string_view line) { return hash64(line); });
+    return prints;
+}
+
+namespace {
+    /// Linear-space Myers diff writing matches of `a` into `match`
+    class myers
+    {
+      public:
+        myers(const uint64_t* a, const uint64_t* b, int32_t* match) : a_(a), b_(b), match_(match)
+        {
+        }
+
+        void run(long x0, long x1, long y0, long y1)
+        {
+            // common prefix and suffix need no search
+            while (x0 < x1 && y0 < y1 && a_[x0] == b_[y0]) {
+                match_[x0++] = static_cast<int32_t>(y0++);
+            }
+            while (x0 < x1 && y0 < y1 && a_[x1 - 1] == b_[y1 - 1]) {
+                match_[--x1] = static_cast<int32_t>(--y1);
+            }
+            if (x0 == x1 || y0 == y1) return;
+
+            long sx, sy, ex, ey;
+            middle_snake(x0, x1, y0, y1, sx, sy, ex, ey);
+            run(x0, sx, y0, sy);
+            for (long x = sx, y = sy; x < ex; ++x, ++y) match_[x] = static_cast<int32_t>(y);
+            run(ex, x1, ey, y1);
+        }
+
+      private:
+        /// Find the middle snake of the edit graph between (x0, y0) and (x1, y1)
+        void middle_snake(long x0, long x1, long y0, long y1, long& sx, long& sy, long& ex,
+                          long& ey)
+        {
+            const long n = x1 - x0, m = y1 - y0;
+            const long delta = n - m;
+            const bool odd = delta & 1;
+            const long max = (n + m + 1) / 2;
+            const long off = max + 1;
+            if (fwd_.size() < static_cast<size_t>(2 * off + 1)) { // gaps are usually small
+                fwd_.resize(2 * off + 1);
+                bwd_.resize(2 * off + 1);
+            }
+            // fwd_[k]: furthest x on diagonal k from the start;
+            // bwd_[k]: furthest distance walked back on diagonal k from the end
+            fwd_[off + 1] = 0;
+            bwd_[off + 1] = 0;
+            for (long d = 0; d <= max; ++d) {
+                for (long k = -d; k <= d; k += 2) {
+                    long x = (k == -d || (k != d && fwd_[off + k - 1] < fwd_[off + k + 1]))
+                                 ? fwd_[off + k + 1]
+                                 : fwd_[off + k - 1] + 1;
+                    long y = x - k;
+                    const long xs = x, ys = y;
+                    while (x < n && y < m && a_[x0 + x] == b_[y0 + y]) ++x, ++y;
+                    fwd_[off + k] = x;
+                    const long rk = delta - k;
+                    if (odd && rk >= -(d - 1) && rk <= d - 1 && x + bwd_[off + rk] >= n) {
+                        sx = x0 + xs, sy = y0 + ys, ex = x0 + x, ey = y0 + y;
+                        return;
+                    }
+                }
+                for (long k = -d; k <= d; k += 2) {
+                    long x = (k == -d || (k != d && bwd_[off + k - 1] < bwd_[off + k + 1]))
+                                 ? bwd_[off + k + 1]
+                                 : bwd_[off + k - 1] + 1;
+                    long y = x - k;
+                    const long xs = x, ys = y;
+                    while (x < n && y < m && a_[x1 - 1 - x] == b_[y1 - 1 - y]) ++x, ++y;
+                    bwd_[off + k] = x;
+                    const long fk = delta - k;
+                    if (!odd && fk >= -d && fk <= d && x + fwd_[off + fk] >= n) {
+                        sx = x1 - x, sy = y1 - y, ex = x1 - xs, ey = y1 - ys;
+                        return;
+                    }
+                }
+            }
+            sx = ex = x1, sy = ey = y1; // unreachable: paths always meet by `max`
+        }
+
+        const uint64_t* a_;
+        const uint64_t* b_;
+        int32_t* match_;
+        std::vector<long> fwd_, bwd_;
+    };
+
+    /// Pairs of lines that occur exactly once in each of `a` and `b`, thinned to
+    /// the longest run increasing in both (patience diff anchors)
+    std::vector<std::pair<uint32_t, uint32_t>> unique_anchors(const std::vector<uint64_t>& a,
+                                                              const std::vector<uint64_t>& b)
+    {
+        constexpr uint32_t none = UINT32_MAX, many = UINT32_MAX - 1;
+        using positions = std::pair<uint32_t, uint32_t>; // in `a` and `b`; `many` once seen twice
+        // most lines are shared, so the longer side holds nearly every distinct line
+        hash_map<positions> table({none, none}, std::max(a.size(), b.size()));
+        // the table is far larger than cache; fetch slots a few lines ahead
+        constexpr size_t ahead = 8;
+        auto count = [&](const std::vector<uint64_t>& lines, uint32_t positions::*pos) {
+            for (size_t i = 0; i < lines.size(); ++i) {
+                if (i + ahead < lines.size()) table.prefetch(lines[i + ahead]);
+                const auto at = static_cast<uint32_t>(i);
+                if (auto e = table.find(lines[i])) {
+                    e->*pos = e->*pos == none ? at : many;
+                } else {
+                    positions p{none, none};
+                    p.*pos = at;
+                    table.insert(lines[i], p);
+                }
+            }
+        };
+        count(a, &positions::first);
+        count(b, &positions::second);
+
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        pairs.reserve(a.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (i + ahead < a.size()) table.prefetch(a[i + ahead]);
+            const auto& e = *table.find(a[i]);
+            if (e.first != many && e.second < many) pairs.push_back(e);
+        }
+
+        // longest increasing subsequence of `pos_b` by patience sorting
+        std::vector<uint32_t> tails;                // pair index ending each pile
+        std::vector<int32_t> prev(pairs.size(), -1); // pair below in the same run
+        for (uint32_t p = 0; p < pairs.size(); ++p) {
+            auto pile = std::lower_bound(tails.begin(), tails.end(), pairs[p].second,
+                                         [&](uint32_t t, uint32_t pos) {
+                                             return pairs[t].second < pos;
+                                         });
+            if (pile != tails.begin()) prev[p] = static_cast<int32_t>(*(pile - 1));
+            if (pile == tails.end()) {
+                tails.push_back(p);
+            } else {
+                *pile = p;
+            }
+        }
+        std::vector<std::pair<uint32_t, uint32_t>> anchors(tails.size());
+        int32_t p = tails.empty() ? -1 : static_cast<int32_t>(tails.back());
+        for (size_t i = anchors.size(); i > 0; --i, p = prev[p]) anchors[i - 1] = pairs[p];
+        return anchors;
+    }
+
+    /// Whether `a[ab, ae)` and `b[bb, be)` hold the same lines
+    bool same_run(const std::vector<uint64_t>& a, size_t ab, size_t ae,
+                  const std::vector<uint64_t>& b, size_t bb, size_t be)
+    {
+        return ae - ab == be - bb && std::equal(a.begin() + ab, a.begin() + ae, b.begin() + bb);
+    }
+} // namespace
+
+std::vector<int32_t> diff_matches(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b)
+{
+    std::vector<int32_t> match(a.size(), -1);
+    myers diff(a.data(), b.data(), match.data());
+    // unique lines pin most of the alignment; Myers only fills the small gaps between them
+    long x = 0, y = 0;
+    for (auto [ai, bi] : unique_anchors(a, b)) {
+        diff.run(x, ai, y, bi);
+        match[ai] = static_cast<int32_t>(bi);
+        x = ai + 1, y = bi + 1;
+    }
+    diff.run(x, static_cast<long>(a.size()), y, static_cast<long>(b.size()));
+    return match;
+}
+
+merge_result merge3(const std::vector<std::string_view>& base,
+                    const std::vector<std::string_view>& ours,
+                    const std::vector<std::string_view>& theirs)
+{
+    const auto pb = fingerprint_lines(base), po = fingerprint_lines(ours),
+               pt = fingerprint_lines(theirs);
+    const auto mo = diff_matches(pb, po), mt = diff_matches(pb, pt);
+
+    merge_result result;
+    result.lines.reserve(std::max(ours.size(), theirs.size()));
+    auto take = [&](const std::vector<std::string_view>& from, size_t begin, size_t end) {
+        result.lines.insert(result.lines.end(), from.begin() + begin, from.begin() + end);
+    };
+    const size_t nb = base.size();
+    size_t i = 0, j = 0, k = 0;
+    while (true) {
+        // lines unchanged on both sides
+        while (i < nb && mo[i] == static_cast<int32_t>(j) && mt[i] == static_cast<int32_t>(k)) {
+            result.lines.push_back(base[i]);
+            ++i, ++j, ++k;
+        }
+        // next base line both sides kept ends the changed region
+        size_t ni = i;
+        while (ni < nb && (mo[ni] < 0 || mt[ni] < 0)) ++ni;
+        const size_t nj = ni < nb ? mo[ni] : ours.size();
+        const size_t nk = ni < nb ? mt[ni] : theirs.size();
+        if (ni == i && nj == j && nk == k) break; // at the end
+
+        if (same_run(pb, i, ni, po, j, nj)) {
+            take(theirs, k, nk);
+        } else if (same_run(pb, i, ni, pt, k, nk) || same_run(po, j, nj, pt, k, nk)) {
+            take(ours, j, nj);
+        } else if (ni == i) {
+            // both sides inserted here: ours, then those of theirs ours lacks
+            const std::vector<uint64_t> added(pt.begin() + k, pt.begin() + nk);
+            const auto in_ours = diff_matches(added, {po.begin() + j, po.begin() + nj});
+            take(ours, j, nj);
+            for (size_t t = 0; t < added.size(); ++t) {
+                if (in_ours[t] < 0) result.lines.push_back(theirs[k + t]);
+            }
+        } else {
+            result.conflicts.push_back(merge_conflict{
+                i, std::vector<std::string_view>(base.begin() + i, base.begin() + ni),
+                std::vector<std::string_view>(ours.begin() + j, ours.begin() + nj),
+                std::vector<std::string_view>(theirs.begin() + k, theirs.begin() + nk)});
+        }
+        i = ni, j = nj, k = nk;
+    }
+    return result;
+}
+
+merge_result merge2(const std::vector<std::string_view>& ours,
+                    const std::vector<std::string_view>& theirs)
+{
+    const auto match = diff_matches(fingerprint_lines(ours), fingerprint_lines(theirs));
+    merge_result result;
+    result.lines.reserve(ours.size());
+    size_t j = 0, k = 0;
+    while (j < ours.size() || k < theirs.size()) {
+        // next line of ours kept in theirs ends the differing region
+        size_t nj = j;
+        while (nj < ours.size() && match[nj] < 0) ++nj;
+        const size_t nk = nj < ours.size() ? match[nj] : theirs.size();
+        if (nj > j || nk > k) {
+            result.conflicts.push_back(merge_conflict{
+                j, {}, std::vector<std::string_view>(ours.begin() + j, ours.begin() + nj),
+                std::vector<std::string_view>(theirs.begin() + k, theirs.begin() + nk)});
+        }
+        if (nj == ours.size()) break;
+        result.lines.push_back(ours[nj]);
+        j = nj + 1, k = nk + 1;
+    }
+    return result;
+}
+
+std::vector<std::filesystem::path> conflicted_copies(const std::filesystem::path& fpath)
+{
+    const auto stem = fpath.stem().string() + " (";
+    const auto ext = fpath.extension().string();
+    std::vector<std::filesystem::path> copies;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(fpath.parent_path(), ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.compare(0, stem.size(), stem) == 0 &&
+            name.find("conflicted copy", stem.size()) != std::string::npos &&
+            entry.path().extension() == ext) {
+            copies.push_back(entry.path());
+        }
+    }
+    std::sort(copies.begin(), copies.end());
+    return copies;
+}
+
+namespace {
+    /// Save `pieces` as the merge base of `fpath`
+    void save_merge_base(const std::filesystem::path& fpath,
+                         const std::vector<std::string_view>& pieces)
+    {
+        const auto path = merge_base_path(fpath);
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (!write_file_atomic(path, pieces)) {
+            ALOG_F(WARNING, "Failed to save merge base '{}'", path.c_str());
+        }
+    }
+
+    /// Remember the stamp of the version of `fpath` ctodo just wrote
+    void note_written(const std::filesystem::path& fpath)
+    {
+        save_cache(state_path(fpath, "written"), file_stamp::of(fpath), {});
+    }
+} // namespace
+
+std::filesystem::path merge_base_path(const std::filesystem::path& fpath)
+{
+    return state_path(fpath, "base");
+}
+
+bool write_todo_file(const std::filesystem::path& fpath, const file_stamp& stamp,
+                     std::string_view current, const std::vector<std::string_view>& pieces)
+{
+    const bool ours = cache_file::open(state_path(fpath, "written"), stamp) != nullptr;
+    if (!ours && conflicted_copies(fpath).empty()) save_merge_base(fpath, {current});
+    if (!write_file_atomic(fpath, pieces)) return false;
+    note_written(fpath);
+    return true;
+}
+
+bool write_merged_file(const std::filesystem::path& fpath, std::string_view merged)
+{
+    if (!write_file_atomic(fpath, {merged})) return false;
+    save_merge_base(fpath, {merged});
+    note_written(fpath);
+    return true;
+}
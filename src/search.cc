@@ -0,0 +1,246 @@
+#include "search.h"
+#include "task.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr unsigned class_bits = 6;
+    constexpr uint32_t key_space = 1u << (3 * class_bits);
+    constexpr uint32_t key_mask = key_space - 1;
+
+    constexpr unsigned char ascii_lower(unsigned char c)
+    {
+        return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c | 0x20) : c;
+    }
+
+    /// Byte -> trigram class: digits 1-10, letters 11-36, everything else hashed into 37-63
+    constexpr std::array<unsigned char, 256> make_classes()
+    {
+        std::array<unsigned char, 256> t{};
+        for (unsigned b = 0; b < 256; ++b) {
+            auto c = ascii_lower(static_cast<unsigned char>(b));
+            if (c >= '0' && c <= '9') {
+                t[b] = static_cast<unsigned char>(1 + c - '0');
+            } else if (c >= 'a' && c <= 'z') {
+                t[b] = static_cast<unsigned char>(11 + c - 'a');
+            } else {
+                t[b] = static_cast<unsigned char>(37 + b % 27);
+            }
+        }
+        return t;
+    }
+    constexpr auto byte_class = make_classes();
+
+    bool icase_equal(const char* a, std::string_view b)
+    {
+        for (size_t i = 0; i < b.size(); ++i) {
+            if (ascii_lower(static_cast<unsigned char>(a[i])) !=
+                ascii_lower(static_cast<unsigned char>(b[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Call `fn` with each trigram key of `text`
+    template <typename Fn>
+    void for_each_key(std::string_view text, Fn&& fn)
+    {
+        uint32_t key = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            key = ((key << class_bits) | byte_class[static_cast<unsigned char>(text[i])]) & key_mask;
+            if (i >= 2) fn(key);
+        }
+    }
+
+    /// Call `fn(index, line)` for each non-empty line of `buffer`
+    template <typename Fn>
+    void for_each_nonempty_line(std::string_view buffer, Fn&& fn)
+    {
+        uint32_t i = 0;
+        for_each_line(buffer, [&](std::string_view line) {
+            if (!line.empty()) fn(i++, line);
+        });
+    }
+} // namespace
+
+size_t icase_find(std::string_view haystack, std::string_view needle, size_t pos)
+{
+    const size_t n = needle.size();
+    if (n == 0) return pos <= haystack.size() ? pos : std::string_view::npos;
+    if (pos >= haystack.size() || n > haystack.size() - pos) return std::string_view::npos;
+    const char* hay = haystack.data();
+    const size_t limit = haystack.size() - n; // last possible match
+    const auto first = ascii_lower(static_cast<unsigned char>(needle[0]));
+    const auto last = ascii_lower(static_cast<unsigned char>(needle[n - 1]));
+    size_t i = pos;
+#if defined(__SSE2__)
+    // OR-ing 0x20 lowercases letters; for letter needles it can also map a few
+    // punctuation bytes onto the needle, which the full compare then rejects
+    auto fold = [](unsigned char c) { return _mm_set1_epi8(c >= 'a' && c <= 'z' ? 0x20 : 0); };
+    const __m128i first_fold = fold(first), last_fold = fold(last);
+    const __m128i first_v = _mm_set1_epi8(static_cast<char>(first));
+    const __m128i last_v = _mm_set1_epi8(static_cast<char>(last));
+    for (; i + 16 <= limit + 1; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hay + i + n - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_or_si128(a, first_fold), first_v),
+                                   _mm_cmpeq_epi8(_mm_or_si128(b, last_fold), last_v));
+        for (unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq)); mask != 0;
+             mask &= mask - 1) {
+            size_t at = i + static_cast<size_t>(__builtin_ctz(mask));
+            if (icase_equal(hay + at, needle)) return at;
+        }
+    }
+#endif
+    for (; i <= limit; ++i) {
+        if (ascii_lower(static_cast<unsigned char>(hay[i])) == first &&
+            icase_equal(hay + i, needle)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+void trigram_index::build(std::string_view buffer)
+{
+    owned_starts_.clear();
+    for_each_nonempty_line(buffer, [&](uint32_t, std::string_view line) {
+        owned_starts_.push_back(static_cast<uint32_t>(line.data() - buffer.data()));
+    });
+
+    // counting sort by key; `last` dedupes keys repeated within a line
+    std::vector<uint32_t> last(key_space, UINT32_MAX);
+    owned_offsets_.assign(key_space + 1, 0);
+    for_each_nonempty_line(buffer, [&](uint32_t i, std::string_view line) {
+        for_each_key(line, [&](uint32_t key) {
+            if (last[key] != i) {
+                last[key] = i;
+                ++owned_offsets_[key + 1];
+            }
+        });
+    });
+    for (uint32_t k = 0; k < key_space; ++k) owned_offsets_[k + 1] += owned_offsets_[k];
+
+    owned_postings_.resize(owned_offsets_[key_space]);
+    std::vector<uint32_t> cursor(owned_offsets_.begin(), owned_offsets_.end() - 1);
+    std::fill(last.begin(), last.end(), UINT32_MAX);
+    for_each_nonempty_line(buffer, [&](uint32_t i, std::string_view line) {
+        for_each_key(line, [&](uint32_t key) {
+            if (last[key] != i) {
+                last[key] = i;
+                owned_postings_[cursor[key]++] = i;
+            }
+        });
+    });
+
+    map_.reset();
+    starts_ = owned_starts_.data();
+    offsets_ = owned_offsets_.data();
+    postings_ = owned_postings_.data();
+    line_count_ = owned_starts_.size();
+}
+
+bool trigram_index::load(const std::filesystem::path& path, const file_stamp& stamp)
+{
+    auto map = cache_file::open(path, stamp);
+    if (map == nullptr || map->size() != 3 ||
+        map->blob(1).size() != (key_space + 1) * sizeof(uint32_t)) {
+        return false;
+    }
+    auto data = [&](size_t i) { return reinterpret_cast<const uint32_t*>(map->blob(i).data()); };
+    owned_starts_.clear();
+    owned_offsets_.clear();
+    owned_postings_.clear();
+    starts_ = data(0);
+    offsets_ = data(1);
+    postings_ = data(2);
+    line_count_ = map->blob(0).size() / sizeof(uint32_t);
+    map_ = std::move(map);
+    return true;
+}
+
+bool trigram_index::save(const std::filesystem::path& path, const file_stamp& stamp) const
+{
+    if (map_ != nullptr) return true; // already persisted
+    return save_cache(path, stamp,
+                      {as_blob(owned_starts_), as_blob(owned_offsets_), as_blob(owned_postings_)});
+}
+
+trigram_index::span trigram_index::postings(uint32_t key) const
+{
+    return span{postings_ + offsets_[key], offsets_[key + 1] - offsets_[key]};
+}
+
+std::string_view trigram_index::line(std::string_view buffer, uint32_t i) const
+{
+    const char* begin = buffer.data() + starts_[i];
+    const char* end = buffer.data() + buffer.size();
+    auto nl = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+    return std::string_view(begin, (nl ? nl : end) - begin);
+}
+
+/// Lines containing short `term`, found by scanning the whole buffer
+std::vector<uint32_t> trigram_index::scan(std::string_view buffer, std::string_view term) const
+{
+    std::vector<uint32_t> result;
+    for (size_t pos = icase_find(buffer, term); pos != std::string_view::npos;) {
+        auto it = std::upper_bound(starts_, starts_ + line_count_, static_cast<uint32_t>(pos));
+        auto i = static_cast<uint32_t>(it - starts_ - 1);
+        auto text = line(buffer, i);
+        if (pos + term.size() <= starts_[i] + text.size()) result.push_back(i);
+        // continue on the next line
+        pos = icase_find(buffer, term, starts_[i] + text.size());
+    }
+    return result;
+}
+
+std::vector<uint32_t> trigram_index::find(std::string_view buffer,
+                                          const std::vector<std::string_view>& terms) const
+{
+    // gather posting lists of all trigrams in all long terms, shortest first
+    std::vector<uint32_t> keys;
+    for (auto term : terms) for_each_key(term, [&](uint32_t key) { keys.push_back(key); });
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<uint32_t> candidates;
+    if (!keys.empty()) {
+        std::vector<span> lists;
+        for (auto key : keys) lists.push_back(postings(key));
+        std::sort(lists.begin(), lists.end(),
+                  [](const span& a, const span& b) { return a.size < b.size; });
+        candidates.assign(lists[0].data, lists[0].data + lists[0].size);
+        for (size_t l = 1; l < lists.size() && !candidates.empty(); ++l) {
+            // candidates are few by now: binary search into the longer list
+            const uint32_t* pos = lists[l].data;
+            const uint32_t* end = pos + lists[l].size;
+            auto keep = candidates.begin();
+            for (auto c : candidates) {
+                pos = std::lower_bound(pos, end, c);
+                if (pos == end) break;
+                if (*pos == c) *keep++ = c;
+            }
+            candidates.erase(keep, candidates.end());
+        }
+    } else if (!terms.empty()) {
+        candidates = scan(buffer, terms[0]);
+    } else {
+        return candidates;
+    }
+
+    auto rejected = [&](uint32_t i) {
+        auto text = line(buffer, i);
+        for (auto term : terms) {
+            if (icase_find(text, term) == std::string_view::npos) return true;
+        }
+        return false;
+    };
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), rejected),
+                     candidates.end());
+    return candidates;
+}
@@ -0,0 +1,60 @@
+#include "snapshot.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+file_lock::file_lock(const std::filesystem::path& fpath)
+{
+    fd_ = ::open(sidecar_path(fpath, "lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) return;
+    int r;
+    while ((r = flock(fd_, LOCK_EX)) != 0 && errno == EINTR) {}
+    if (r != 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+file_lock::~file_lock()
+{
+    // closing the descriptor releases the lock
+    if (fd_ >= 0) close(fd_);
+}
+
+file_snapshot::~file_snapshot()
+{
+    if (map_ != nullptr) munmap(map_, stamp_.size);
+    if (fd_ >= 0) close(fd_);
+}
+
+std::shared_ptr<file_snapshot> file_snapshot::open(const std::filesystem::path& fpath)
+{
+    int fd = ::open(fpath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    std::shared_ptr<file_snapshot> snapshot(new file_snapshot);
+    snapshot->fd_ = fd;
+    // size the mapping from the descriptor, not the path, which a writer may
+    // have replaced since it was opened
+    snapshot->stamp_ = file_stamp::of(fd);
+    if (snapshot->stamp_.size == 0) return snapshot; // empty files cannot be mapped
+    void* map = mmap(nullptr, snapshot->stamp_.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return nullptr;
+    snapshot->map_ = map;
+    return snapshot;
+}
+
+bool file_snapshot::read(char* out) const
+{
+    size_t done = 0;
+    while (done < stamp_.size) {
+        const ssize_t r = pread(fd_, out + done, stamp_.size - done, static_cast<off_t>(done));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false; // error, or truncated since it was opened
+        done += static_cast<size_t>(r);
+    }
+    return true;
+}
+
+bool file_snapshot::intact() const { return file_stamp::of(fd_) == stamp_; }
@@ -0,0 +1,155 @@
+#include "stats.h"
+#include "intern.h"
+#include "task.h"
+#include <algorithm>
+#include <fmt/format.h>
+#include <iterator>
+#include <thread>
+
+/// Smallest share of the buffer given its own thread; scanning 1 MiB takes about
+/// as long as starting and joining a worker
+constexpr size_t min_chunk_size = 1 << 20;
+
+/// Bucket index for a task created `days` ago
+static size_t age_bucket(int days)
+{
+    if (days <= 7) return 0;
+    if (days <= 31) return 1;
+    if (days <= 92) return 2;
+    if (days <= 365) return 3;
+    return 4;
+}
+
+/// Single-threaded scan of whole lines in `chunk`
+static task_stats scan(std::string_view chunk, int today)
+{
+    task_stats st;
+    intern_table ids;
+    for_each_line(chunk, [&](std::string_view line) {
+        if (line.empty()) return;
+
+        ++st.total;
+        auto h = parse_header(line);
+        if (h.done) {
+            ++st.done;
+            if (h.completed == no_date) return;
+            if (auto weeks = (today - h.completed) / 7; weeks >= 0 && weeks < int(velocity_weeks)) {
+                ++st.weekly[weeks];
+            }
+            if (h.created != no_date && h.completed >= h.created) {
+                st.lead_days += h.completed - h.created;
+                ++st.lead_count;
+            }
+            return;
+        }
+        ++st.priority[h.priority ? h.priority - 'A' : 26];
+        ++st.age[h.created == no_date ? age_buckets - 1 : age_bucket(today - h.created)];
+        for_each_word(line.substr(h.offset), [&](std::string_view word) {
+            std::string_view text;
+            auto kind = classify_word(word, text);
+            if (kind != tag_kind::context && kind != tag_kind::project) return;
+            auto id = ids.intern(text);
+            if (id == st.tags.size()) st.tags.emplace_back(text, 0);
+            ++st.tags[id].second;
+        });
+    });
+    return st;
+}
+
+void merge_stats(task_stats& into, const task_stats& from)
+{
+    into.total += from.total;
+    into.done += from.done;
+    for (size_t i = 0; i < into.priority.size(); ++i) into.priority[i] += from.priority[i];
+    for (size_t i = 0; i < age_buckets; ++i) into.age[i] += from.age[i];
+    for (size_t i = 0; i < velocity_weeks; ++i) into.weekly[i] += from.weekly[i];
+    into.lead_days += from.lead_days;
+    into.lead_count += from.lead_count;
+
+    intern_table ids(into.tags.size() + from.tags.size());
+    for (const auto& tag : into.tags) ids.intern(tag.first);
+    for (const auto& [text, count] : from.tags) {
+        auto id = ids.intern(text);
+        if (id == into.tags.size()) into.tags.emplace_back(text, 0);
+        into.tags[id].second += count;
+    }
+}
+
+task_stats collect_stats(std::string_view buffer, int today, unsigned threads)
+{
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunks = std::min<size_t>(threads, buffer.size() / min_chunk_size + 1);
+
+    // split on line boundaries
+    std::vector<std::string_view> parts;
+    size_t begin = 0;
+    for (size_t i = 1; i <= chunks && begin < buffer.size(); ++i) {
+        size_t end = buffer.size();
+        if (i < chunks) {
+            auto nl = buffer.find('\n', std::max(begin, buffer.size() * i / chunks));
+            if (nl != std::string_view::npos) end = nl + 1;
+        }
+        parts.push_back(buffer.substr(begin, end - begin));
+        begin = end;
+    }
+
+    std::vector<task_stats> partial(parts.size());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < parts.size(); ++i) {
+        workers.emplace_back([&, i] { partial[i] = scan(parts[i], today); });
+    }
+    if (!parts.empty()) partial[0] = scan(parts[0], today);
+    for (auto& w : workers) w.join();
+
+    task_stats result;
+    for (const auto& p : partial) merge_stats(result, p);
+    std::sort(result.tags.begin(), result.tags.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    return result;
+}
+
+std::string format_stats(const task_stats& todo, const task_stats& done)
+{
+    std::string out;
+    auto it = std::back_inserter(out);
+    const size_t open = todo.total - todo.done;
+    fmt::format_to(it, "todo.txt: {} tasks ({} open, {} done)\n", todo.total, open, todo.done);
+    fmt::format_to(it, "done.txt: {} tasks\n", done.total);
+
+    fmt::format_to(it, "\nOpen by priority\n");
+    for (size_t i = 0; i < 26; ++i) {
+        if (todo.priority[i] > 0) {
+            fmt::format_to(it, "  ({})  {:>8}\n", char('A' + i), todo.priority[i]);
+        }
+    }
+    fmt::format_to(it, "  none {:>8}\n", todo.priority[26]);
+
+    for (char sigil : {'@', '+'}) {
+        fmt::format_to(it, "\nOpen by {}\n", sigil == '@' ? "context" : "project");
+        for (const auto& [tag, count] : todo.tags) {
+            if (tag[0] == sigil) fmt::format_to(it, "  {:<24} {:>8}\n", tag, count);
+        }
+    }
+
+    static const char* age_labels[age_buckets] = {"<= 1 week",  "<= 1 month", "<= 3 months",
+                                                  "<= 1 year",  "older",      "undated"};
+    fmt::format_to(it, "\nOpen by age\n");
+    for (size_t i = 0; i < age_buckets; ++i) {
+        fmt::format_to(it, "  {:<12} {:>8}\n", age_labels[i], todo.age[i]);
+    }
+
+    task_stats completed = todo;
+    merge_stats(completed, done);
+    size_t recent = 0;
+    for (auto n : completed.weekly) recent += n;
+    fmt::format_to(it, "\nCompleted per week (last 7 days first)\n ");
+    for (auto n : completed.weekly) fmt::format_to(it, " {}", n);
+    fmt::format_to(it, "\n  average {:.1f}/week over {} weeks\n",
+                   static_cast<double>(recent) / velocity_weeks, velocity_weeks);
+    if (completed.lead_count > 0) {
+        fmt::format_to(it, "  average {:.1f} days from creation to completion\n",
+                       static_cast<double>(completed.lead_days) / completed.lead_count);
+    }
+    return out;
+}
@@ -0,0 +1,200 @@
+#include "task.h"
+#include "search.h"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+
+tag_kind classify_word(std::string_view word, std::string_view& interned)
+{
+    if (word.size() < 2) return tag_kind::none;
+    switch (word[0]) {
+    case '@':
+        interned = word;
+        return tag_kind::context;
+    case '+':
+        interned = word;
+        return tag_kind::project;
+    default:
+        break;
+    }
+    // key:value where key is [A-Za-z0-9_-]+ and value is non-empty and not a url
+    auto pos = word.find(':');
+    if (pos == std::string_view::npos || pos == 0 || pos + 1 >= word.size() ||
+        word[pos + 1] == '/') {
+        return tag_kind::none;
+    }
+    for (size_t i = 0; i < pos; ++i) {
+        auto c = static_cast<unsigned char>(word[i]);
+        if (!std::isalnum(c) && c != '_' && c != '-') return tag_kind::none;
+    }
+    interned = word.substr(0, pos + 1);
+    return tag_kind::key;
+}
+
+void normalize_text(std::string_view text, std::string& out)
+{
+    out.resize(text.size());
+    out.resize(normalize_text(text, out.data()));
+}
+
+size_t normalize_text(std::string_view text, char* out)
+{
+    char* dest = out;
+    bool gap = false;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') {
+            gap = dest != out;
+            continue;
+        }
+        if (gap) *dest++ = ' ';
+        gap = false;
+        *dest++ = c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+    }
+    return dest - out;
+}
+
+task parse_task(std::string_view line, intern_table& tags, std::pmr::memory_resource* mr)
+{
+    // collect on the stack first so the arena sees one exactly-sized allocation
+    std::array<tag_ref, 16> found;
+    size_t count = 0;
+    task t{line, std::pmr::vector<tag_ref>(mr)};
+    for_each_word(line, [&](std::string_view word) {
+        std::string_view text;
+        if (auto kind = classify_word(word, text); kind != tag_kind::none) {
+            tag_ref ref{tags.intern(text), kind};
+            if (count < found.size()) {
+                found[count++] = ref;
+            } else {
+                if (t.tags.empty()) t.tags.assign(found.begin(), found.end());
+                t.tags.push_back(ref);
+            }
+        }
+    });
+    if (t.tags.empty()) t.tags.assign(found.begin(), found.begin() + count);
+    return t;
+}
+
+bool parse_date(std::string_view word, int& days)
+{
+    if (word.size() != 10 || word[4] != '-' || word[7] != '-') return false;
+    int v[8];
+    size_t n = 0;
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (!std::isdigit(static_cast<unsigned char>(word[i]))) return false;
+        v[n++] = word[i] - '0';
+    }
+    int y = v[0] * 1000 + v[1] * 100 + v[2] * 10 + v[3];
+    unsigned m = static_cast<unsigned>(v[4] * 10 + v[5]);
+    unsigned d = static_cast<unsigned>(v[6] * 10 + v[7]);
+    if (m < 1 || m > 12 || d < 1 || d > 31) return false;
+    // days_from_civil (H. Hinnant)
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const auto yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    days = era * 146097 + static_cast<int>(doe) - 719468;
+    return true;
+}
+
+std::string format_date(int days)
+{
+    // civil_from_days (H. Hinnant)
+    days += 719468;
+    const int era = (days >= 0 ? days : days - 146096) / 146097;
+    const auto doe = static_cast<unsigned>(days - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    const int y = static_cast<int>(yoe) + era * 400 + (m <= 2);
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02u-%02u", y, m, d);
+    return buf;
+}
+
+int current_day()
+{
+    std::time_t now = std::time(nullptr);
+    std::tm local;
+    localtime_r(&now, &local);
+    char buf[11];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d", &local);
+    int days = 0;
+    parse_date(std::string_view(buf, 10), days);
+    return days;
+}
+
+task_header parse_header(std::string_view line)
+{
+    task_header h{false, 0, no_date, no_date, 0};
+    size_t offset = 0;
+    int dates = 1; // dates still allowed: completion + creation, or creation only
+    for (bool first = true;; first = false) {
+        while (offset < line.size() && line[offset] == ' ') ++offset;
+        size_t end = line.find(' ', offset);
+        auto word = line.substr(offset, end == std::string_view::npos ? end : end - offset);
+        int days;
+        if (first && word == "x") {
+            h.done = true;
+            dates = 2;
+        } else if (first && word.size() == 3 && word[0] == '(' && word[2] == ')' &&
+                   std::isupper(static_cast<unsigned char>(word[1]))) {
+            h.priority = word[1];
+        } else if (dates > 0 && parse_date(word, days)) {
+            if (h.done && dates == 2) {
+                h.completed = days;
+            } else {
+                h.created = days;
+            }
+            --dates;
+        } else {
+            h.offset = offset;
+            return h;
+        }
+        if (end == std::string_view::npos) {
+            h.offset = line.size();
+            return h;
+        }
+        offset = end + 1;
+    }
+}
+
+size_t text_offset(std::string_view line) { return parse_header(line).offset; }
+
+bool has_tag(const task& t, intern_table::id_type id)
+{
+    return std::any_of(t.tags.begin(), t.tags.end(),
+                       [id](const tag_ref& ref) { return ref.id == id; });
+}
+
+void filter_tasks(std::pmr::vector<task>& tasks, const std::vector<std::string>& terms,
+                  const intern_table& tags)
+{
+    auto mr = tasks.get_allocator().resource();
+    std::pmr::vector<intern_table::id_type> ids(mr);
+    std::pmr::vector<std::string_view> words(mr);
+    for (const auto& term : terms) {
+        std::string_view interned;
+        if (auto kind = classify_word(term, interned);
+            kind == tag_kind::context || kind == tag_kind::project) {
+            ids.push_back(tags.find(interned));
+        } else {
+            words.push_back(term);
+        }
+    }
+    auto rejected = [&](const task& t) {
+        for (auto id : ids) {
+            if (id == intern_table::npos || !has_tag(t, id)) return true;
+        }
+        for (auto word : words) {
+            if (icase_find(t.text, word) == std::string_view::npos) return true;
+        }
+        return false;
+    };
+    tasks.erase(std::remove_if(tasks.begin(), tasks.end(), rejected), tasks.end());
+}
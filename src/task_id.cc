@@ -0,0 +1,90 @@
+#include "task_id.h"
+#include "hash.h"
+#include "task.h"
+#include <algorithm>
+
+/// Base-32 digits without the easily confused i, l, o and u
+static constexpr char id_alphabet[] = "0123456789abcdefghjkmnpqrstvwxyz";
+
+constexpr uint32_t no_line = UINT32_MAX;
+
+task_ids::task_ids(const std::pmr::vector<std::string_view>& lines, std::pmr::memory_resource* mr)
+    : ids_(mr), lines_(no_line, lines.size(), mr)
+{
+    // hash every description first, so the index pass can fetch its slots ahead
+    ids_.reserve(lines.size());
+    std::pmr::string normalized(mr);
+    for (auto line : lines) {
+        const auto header = parse_header(line);
+        const auto text = line.substr(header.offset);
+        if (normalized.size() < text.size()) normalized.resize(text.size());
+        const size_t length = normalize_text(text, normalized.data());
+        const uint64_t salt = header.created == no_date ? 0 : static_cast<uint32_t>(header.created);
+        ids_.push_back(hash64(std::string_view(normalized.data(), length), salt));
+    }
+
+    hash_map<uint32_t> copies(0, 0, mr); // description hash -> last derived ordinal taken
+    constexpr size_t ahead = 8;
+    constexpr unsigned shift = 64 - id_bits;
+    for (size_t i = 0; i < ids_.size(); ++i) {
+        if (i + ahead < ids_.size()) lines_.prefetch(ids_[i + ahead] >> shift);
+        // a taken id means an identical task came earlier: the n-th copy takes the n-th
+        // derived id (a true collision between different tasks is resolved the same way)
+        const uint64_t base = ids_[i];
+        uint64_t id = base >> shift;
+        if (lines_.find(id) != nullptr) {
+            // resume after the last ordinal this description took, so n copies cost O(n)
+            uint32_t* last = copies.find(base);
+            uint32_t ordinal = last == nullptr ? 1 : *last + 1;
+            while (lines_.find(id = detail::fmix(base + ordinal * detail::hash_k0) >> shift)) {
+                ++ordinal;
+            }
+            if (last == nullptr) {
+                copies.insert(base, ordinal);
+            } else {
+                *last = ordinal;
+            }
+        }
+        lines_.insert(id, static_cast<uint32_t>(i));
+        ids_[i] = id;
+    }
+}
+
+size_t task_ids::find(uint64_t id) const
+{
+    const uint32_t* line = lines_.find(id);
+    return line == nullptr ? npos : *line;
+}
+
+size_t task_ids::resolve(std::string_view arg, const std::pmr::vector<uint32_t>& numbers) const
+{
+    if (uint64_t id; parse(arg, id)) {
+        if (auto i = find(id); i != npos) return i;
+    }
+    if (arg.empty() || arg.size() > 9 ||
+        !std::all_of(arg.begin(), arg.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+        return npos;
+    }
+    const size_t number = std::stoul(std::string(arg));
+    const auto it = std::lower_bound(numbers.begin(), numbers.end(), number);
+    return it != numbers.end() && *it == number ? static_cast<size_t>(it - numbers.begin()) : npos;
+}
+
+std::string task_ids::format(uint64_t id)
+{
+    std::string text(id_chars, '0');
+    for (size_t i = id_chars; i > 0; --i, id >>= 5) text[i - 1] = id_alphabet[id & 31];
+    return text;
+}
+
+bool task_ids::parse(std::string_view text, uint64_t& id)
+{
+    if (text.size() != id_chars) return false;
+    id = 0;
+    for (char c : text) {
+        const char* digit = std::find(id_alphabet, id_alphabet + 32, c | 0x20);
+        if (digit == id_alphabet + 32) return false;
+        id = id << 5 | static_cast<uint64_t>(digit - id_alphabet);
+    }
+    return true;
+}
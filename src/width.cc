@@ -0,0 +1,255 @@
+#include "width.h"
+#include "task.h"
+#include <algorithm>
+#include <cstdint>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+    struct range
+    {
+        char32_t first, last;
+    };
+
+    /// Nonspacing/enclosing marks, zero-width format characters and modifiers
+    constexpr range zero_width[] = {
+        {0x0300, 0x036F},   {0x0483, 0x0489},   {0x0591, 0x05BD},   {0x05BF, 0x05BF},
+        {0x05C1, 0x05C2},   {0x05C4, 0x05C5},   {0x05C7, 0x05C7},   {0x0610, 0x061A},
+        {0x061C, 0x061C},   {0x064B, 0x065F},   {0x0670, 0x0670},   {0x06D6, 0x06DC},
+        {0x06DF, 0x06E4},   {0x06E7, 0x06E8},   {0x06EA, 0x06ED},   {0x0711, 0x0711},
+        {0x0730, 0x074A},   {0x07A6, 0x07B0},   {0x07EB, 0x07F3},   {0x0816, 0x082D},
+        {0x0859, 0x085B},   {0x08D3, 0x0902},   {0x093A, 0x093A},   {0x093C, 0x093C},
+        {0x0941, 0x0948},   {0x094D, 0x094D},   {0x0951, 0x0957},   {0x0962, 0x0963},
+        {0x0981, 0x0981},   {0x09BC, 0x09BC},   {0x09C1, 0x09C4},   {0x09CD, 0x09CD},
+        {0x0A01, 0x0A02},   {0x0A3C, 0x0A3C},   {0x0A41, 0x0A51},   {0x0A70, 0x0A71},
+        {0x0A81, 0x0A82},   {0x0ABC, 0x0ABC},   {0x0AC1, 0x0AC8},   {0x0ACD, 0x0ACD},
+        {0x0B01, 0x0B01},   {0x0B3C, 0x0B3C},   {0x0B41, 0x0B44},   {0x0B4D, 0x0B4D},
+        {0x0BC0, 0x0BC0},   {0x0BCD, 0x0BCD},   {0x0C3E, 0x0C40},   {0x0C46, 0x0C56},
+        {0x0CBC, 0x0CBC},   {0x0CCC, 0x0CCD},   {0x0D41, 0x0D44},   {0x0D4D, 0x0D4D},
+        {0x0DCA, 0x0DCA},   {0x0DD2, 0x0DD6},   {0x0E31, 0x0E31},   {0x0E34, 0x0E3A},
+        {0x0E47, 0x0E4E},   {0x0EB1, 0x0EB1},   {0x0EB4, 0x0EBC},   {0x0EC8, 0x0ECD},
+        {0x0F18, 0x0F19},   {0x0F35, 0x0F39},   {0x0F71, 0x0F84},   {0x0F86, 0x0F87},
+        {0x0F8D, 0x0FBC},   {0x102D, 0x1030},   {0x1032, 0x1037},   {0x1039, 0x103A},
+        {0x1160, 0x11FF},   {0x135D, 0x135F},   {0x1712, 0x1714},   {0x17B4, 0x17B5},
+        {0x17B7, 0x17BD},   {0x17C6, 0x17C6},   {0x17C9, 0x17D3},   {0x180B, 0x180E},
+        {0x1AB0, 0x1AFF},   {0x1DC0, 0x1DFF},   {0x200B, 0x200F},   {0x202A, 0x202E},
+        {0x2060, 0x2064},   {0x20D0, 0x20FF},   {0x2CEF, 0x2CF1},   {0x2DE0, 0x2DFF},
+        {0x302A, 0x302D},   {0x3099, 0x309A},   {0xA66F, 0xA672},   {0xA674, 0xA67D},
+        {0xA69E, 0xA69F},   {0xA6F0, 0xA6F1},   {0xA8E0, 0xA8F1},   {0xFB1E, 0xFB1E},
+        {0xFE00, 0xFE0F},   {0xFE20, 0xFE2F},   {0xFEFF, 0xFEFF},   {0x1D167, 0x1D169},
+        {0x1D173, 0x1D182}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE0001}, {0xE0020, 0xE007F},
+        {0xE0100, 0xE01EF},
+    };
+
+    /// East Asian Wide (W) and Fullwidth (F) ranges, including emoji presentation
+    constexpr range double_width[] = {
+        {0x1100, 0x115F},   {0x231A, 0x231B},   {0x2329, 0x232A},   {0x23E9, 0x23EC},
+        {0x23F0, 0x23F0},   {0x23F3, 0x23F3},   {0x25FD, 0x25FE},   {0x2614, 0x2615},
+        {0x2648, 0x2653},   {0x267F, 0x267F},   {0x2693, 0x2693},   {0x26A1, 0x26A1},
+        {0x26AA, 0x26AB},   {0x26BD, 0x26BE},   {0x26C4, 0x26C5},   {0x26CE, 0x26CE},
+        {0x26D4, 0x26D4},   {0x26EA, 0x26EA},   {0x26F2, 0x26F3},   {0x26F5, 0x26F5},
+        {0x26FA, 0x26FA},   {0x26FD, 0x26FD},   {0x2705, 0x2705},   {0x270A, 0x270B},
+        {0x2728, 0x2728},   {0x274C, 0x274C},   {0x274E, 0x274E},   {0x2753, 0x2755},
+        {0x2757, 0x2757},   {0x2795, 0x2797},   {0x27B0, 0x27B0},   {0x27BF, 0x27BF},
+        {0x2B1B, 0x2B1C},   {0x2B50, 0x2B50},   {0x2B55, 0x2B55},   {0x2E80, 0x303E},
+        {0x3041, 0x3247},   {0x3250, 0x4DBF},   {0x4E00, 0xA4CF},   {0xA960, 0xA97F},
+        {0xAC00, 0xD7A3},   {0xF900, 0xFAFF},   {0xFE10, 0xFE19},   {0xFE30, 0xFE6F},
+        {0xFF00, 0xFF60},   {0xFFE0, 0xFFE6},   {0x16FE0, 0x16FE4}, {0x17000, 0x18CFF},
+        {0x1B000, 0x1B2FF}, {0x1F004, 0x1F004}, {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E},
+        {0x1F191, 0x1F19A}, {0x1F200, 0x1F251}, {0x1F300, 0x1F320}, {0x1F32D, 0x1F335},
+        {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3},
+        {0x1F3E0, 0x1F3F0}, {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440},
+        {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D}, {0x1F54B, 0x1F54E}, {0x1F550, 0x1F567},
+        {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4}, {0x1F5FB, 0x1F64F},
+        {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6D7},
+        {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7EB}, {0x1F90C, 0x1F93A},
+        {0x1F93C, 0x1F945}, {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAFF}, {0x20000, 0x2FFFD},
+        {0x30000, 0x3FFFD},
+    };
+
+    template <size_t N>
+    bool in_table(char32_t cp, const range (&table)[N])
+    {
+        if (cp < table[0].first || cp > table[N - 1].last) return false;
+        auto it = std::upper_bound(std::begin(table), std::end(table), cp,
+                                   [](char32_t c, const range& r) { return c < r.first; });
+        return it != std::begin(table) && cp <= (it - 1)->last;
+    }
+
+    /// Decode one UTF-8 sequence at `p`; invalid bytes decode as themselves, length 1
+    char32_t decode_utf8(const unsigned char* p, const unsigned char* end, size_t& len)
+    {
+        unsigned char c = p[0];
+        size_t n = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        if (n == 1 || static_cast<size_t>(end - p) < n) {
+            len = 1;
+            return c;
+        }
+        char32_t cp = c & (0x7F >> n);
+        for (size_t i = 1; i < n; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                len = 1;
+                return c;
+            }
+            cp = (cp << 6) | (p[i] & 0x3F);
+        }
+        len = n;
+        return cp;
+    }
+
+    /// Skip an escape sequence starting at ESC `p`: CSI (ESC [ ... final) or OSC
+    /// (ESC ] ... BEL / ESC \); anything else is a two-byte escape.
+    const unsigned char* skip_escape(const unsigned char* p, const unsigned char* end)
+    {
+        if (end - p < 2) return end;
+        if (p[1] == '[') {
+            p += 2;
+            while (p < end && (*p < 0x40 || *p > 0x7E)) ++p;
+            return p < end ? p + 1 : end;
+        }
+        if (p[1] == ']') {
+            p += 2;
+            while (p < end) {
+                if (*p == 0x07) return p + 1;
+                if (*p == 0x1B && p + 1 < end && p[1] == '\\') return p + 2;
+                ++p;
+            }
+            return end;
+        }
+        return p + 2;
+    }
+
+    /// Count leading printable ASCII bytes (0x20-0x7F) of [p, end)
+    size_t ascii_run(const unsigned char* p, const unsigned char* end)
+    {
+        const unsigned char* start = p;
+#if defined(__SSE2__)
+        // signed compare: bytes >= 0x80 are negative, so one compare catches
+        // controls (including ESC) and UTF-8 lead/continuation bytes
+        const __m128i space = _mm_set1_epi8(0x20);
+        while (end - p >= 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            int mask = _mm_movemask_epi8(_mm_cmplt_epi8(v, space));
+            if (mask != 0) return static_cast<size_t>(p - start) + __builtin_ctz(mask);
+            p += 16;
+        }
+#endif
+        while (p < end && *p >= 0x20 && *p < 0x80) ++p;
+        return static_cast<size_t>(p - start);
+    }
+} // namespace
+
+int codepoint_width(char32_t cp)
+{
+    if (cp < 0x20 || (cp >= 0x7F && cp < 0xA0)) return 0;
+    if (cp < 0x300) return 1;
+    if (in_table(cp, zero_width)) return 0;
+    if (in_table(cp, double_width)) return 2;
+    return 1;
+}
+
+size_t display_width(std::string_view str)
+{
+    auto p = reinterpret_cast<const unsigned char*>(str.data());
+    auto end = p + str.size();
+    size_t width = 0;
+    while (p < end) {
+        size_t run = ascii_run(p, end);
+        width += run;
+        p += run;
+        if (p == end) break;
+        if (*p == 0x1B) {
+            p = skip_escape(p, end);
+        } else if (*p < 0x80) {
+            ++p; // other control characters take no columns
+        } else {
+            size_t len;
+            width += codepoint_width(decode_utf8(p, end, len));
+            p += len;
+        }
+    }
+    return width;
+}
+
+size_t width_prefix(std::string_view str, size_t max_width)
+{
+    auto begin = reinterpret_cast<const unsigned char*>(str.data());
+    auto p = begin;
+    auto end = p + str.size();
+    size_t width = 0;
+    while (p < end) {
+        if (*p == 0x1B) {
+            p = skip_escape(p, end);
+            continue;
+        }
+        size_t len = 1;
+        int w = *p < 0x80 ? (*p >= 0x20) : codepoint_width(decode_utf8(p, end, len));
+        if (width + w > max_width) break;
+        width += w;
+        p += len;
+    }
+    return static_cast<size_t>(p - begin);
+}
+
+void wrap_line(std::string_view line, size_t cols, size_t indent, std::pmr::string& out)
+{
+    if (indent * 2 > cols) indent = 0; // hanging indent would leave too little room
+    while (!line.empty() && line.back() == ' ') line.remove_suffix(1);
+
+    // Greedy single pass: remember the last space on the current row and
+    // break there once a character would cross `cols`.
+    auto begin = reinterpret_cast<const unsigned char*>(line.data());
+    auto end = begin + line.size();
+    const unsigned char* row = begin;     // start of current row
+    const unsigned char* space = nullptr; // last space in current row
+    size_t col = 0, col_after_space = 0;
+    auto emit = [&](const unsigned char* to, const unsigned char* next) {
+        while (to > row && to[-1] == ' ') --to; // spaces before the break may pass `cols`
+        out.append(reinterpret_cast<const char*>(row), static_cast<size_t>(to - row));
+        out.push_back('\n');
+        out.append(indent, ' ');
+        row = next;
+        space = nullptr;
+    };
+    for (auto p = begin; p < end;) {
+        unsigned char c = *p;
+        if (c == ' ') {
+            space = p++;
+            col_after_space = ++col;
+            continue;
+        }
+        if (c == 0x1B) {
+            p = skip_escape(p, end);
+            continue;
+        }
+        // fast path: a run of visible ASCII that still fits
+        auto q = p;
+        while (q < end && *q > 0x20 && *q < 0x7F) ++q;
+        if (q > p && col + static_cast<size_t>(q - p) <= cols) {
+            col += static_cast<size_t>(q - p);
+            p = q;
+            continue;
+        }
+        size_t len = 1;
+        int w = c < 0x80 ? (c >= 0x20) : codepoint_width(decode_utf8(p, end, len));
+        if (col + w > cols && (space != nullptr || p > row)) {
+            if (space != nullptr) {
+                emit(space, space + 1);
+                if (indent + (col - col_after_space) + w > cols) {
+                    // the word still does not fit after the indent: rescan it to hard-break it
+                    p = row;
+                    col = indent;
+                    continue;
+                }
+                col = indent + (col - col_after_space);
+            } else {
+                emit(p, p); // no space on this row: hard-break the word
+                col = indent;
+            }
+        }
+        col += w;
+        p += len;
+    }
+    out.append(reinterpret_cast<const char*>(row), static_cast<size_t>(end - row));
+}
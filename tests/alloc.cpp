@@ -0,0 +1,47 @@
+#include "doctest.h"
+#include "arena.h"
+#include "config.h"
+#include "format.h"
+#include "intern.h"
+#include "task.h"
+#include "task_id.h"
+#include <fmt/format.h>
+#include <iterator>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if COUNT_ALLOCATIONS
+TEST_CASE("listing allocates from its arena only")
+{
+    // short and long lines, tags, dates, wide characters and copies of one task
+    std::string raw;
+    for (int i = 0; i < 20000; ++i) {
+        fmt::format_to(std::back_inserter(raw), "({}) 2026-10-{:02} task {} +project{} @ctx{}",
+                       char('A' + i % 26), i % 28 + 1, i % 5000, i % 50, i % 7);
+        if (i % 3 == 0) raw += " due:2026-11-01 see https://example.com/tasks";
+        if (i % 11 == 0) raw += " 日本語のタスクを書いてみるとどうなるでしょうか";
+        raw += '\n';
+    }
+    const size_t line_count = 20000;
+    arena pool(arena_size_for(raw.size(), line_count));
+    auto mr = pool.resource();
+    const auto paint = palette::current();
+
+    const auto allocs_before = global_allocations();
+    std::pmr::vector<std::string_view> lines(mr);
+    lines.reserve(line_count);
+    for_each_line(raw, [&](std::string_view line) { lines.push_back(line); });
+    intern_table tags(256, mr);
+    auto tasks = parse_lines(lines, tags, mr);
+    const task_ids ids(lines, mr);
+    for (size_t i = 0; i < tasks.size(); ++i) tasks[i].id = ids.id(i);
+    const auto out = format_lines(tasks, paint, mr, overflow_mode::wrap, 40, true);
+    const auto allocs = global_allocations() - allocs_before;
+
+    CHECK(out.size() > raw.size());
+    CHECK(allocs == 0);
+    CHECK(pool.overflow_allocations() == 0);
+}
+#endif // COUNT_ALLOCATIONS
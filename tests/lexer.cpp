@@ -0,0 +1,98 @@
+#include "doctest.h"
+#include "lexer.h"
+#include "task.h"
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    bool same(const line_span& a, const line_span& b)
+    {
+        return a.offset == b.offset && a.length == b.length && a.kind == b.kind;
+    }
+
+    /// `word` is `key://rest`, which classify_word leaves alone as a url
+    bool is_url(std::string_view word)
+    {
+        const auto pos = word.find("://");
+        if (pos == 0 || pos == std::string_view::npos || pos + 3 >= word.size()) return false;
+        return std::all_of(word.begin(), word.begin() + pos, [](unsigned char c) {
+            return std::isalnum(c) || c == '_' || c == '-';
+        });
+    }
+
+    /// Spans of `line` as parse_header and classify_word see it
+    std::vector<line_span> reference_spans(std::string_view line)
+    {
+        const auto header = parse_header(line);
+        std::vector<line_span> spans;
+        bool first = true;
+        for (size_t pos = 0; pos < line.size();) {
+            if (line[pos] == ' ') {
+                ++pos;
+                continue;
+            }
+            const size_t end = std::min(line.find(' ', pos), line.size());
+            const auto word = line.substr(pos, end - pos);
+            auto emit = [&](span_kind kind) {
+                spans.push_back(
+                    {static_cast<uint32_t>(pos), static_cast<uint32_t>(end - pos), kind});
+            };
+            if (pos < header.offset) {
+                emit(first && header.done       ? span_kind::done
+                     : first && header.priority ? span_kind::priority
+                                                : span_kind::date);
+            } else {
+                std::string_view interned;
+                switch (classify_word(word, interned)) {
+                case tag_kind::context:
+                    emit(span_kind::context);
+                    break;
+                case tag_kind::project:
+                    emit(span_kind::project);
+                    break;
+                case tag_kind::key:
+                    emit(span_kind::key);
+                    break;
+                case tag_kind::none:
+                    if (is_url(word)) emit(span_kind::url);
+                    break;
+                }
+            }
+            first = false;
+            pos = end;
+        }
+        return spans;
+    }
+} // namespace
+
+TEST_CASE("lexer agrees with parse_header and classify_word on random lines")
+{
+    // fragments close to every token, and to every way of almost being one
+    const std::vector<std::string_view> fragments{
+        "x", "X", "(A)", "(Z)", "(a)", "(", ")", "(B)x",                    // header
+        "2026-10-19", "2026-13-01", "2026-02-30", "2026-1", "9", "0", "-", // dates
+        "@", "+", "@@", "+-", "A", "_", "~", "\t", "é",                    // tags
+        ":", "/", "//", "://", "http", "key", "due", "x:", "a:b",          // keys and urls
+    };
+    std::mt19937 rng(20261019);
+    std::uniform_int_distribution<size_t> pick(0, fragments.size() - 1), count(0, 3), gap(0, 7);
+    std::pmr::vector<line_span> spans;
+    std::string line;
+    std::string mismatch; // first line the two disagree on, printed if any
+    for (size_t words = 0; words < 2'000'000 && mismatch.empty();) {
+        line.clear();
+        for (size_t n = count(rng) * 2 + 1; n > 0; --n, ++words) {
+            line.append(gap(rng) == 0 ? 2 : line.empty() ? 0 : 1, ' ');
+            for (size_t k = count(rng) + 1; k > 0; --k) line.append(fragments[pick(rng)]);
+        }
+        lex_line(line, spans);
+        const auto expected = reference_spans(line);
+        if (!std::equal(spans.begin(), spans.end(), expected.begin(), expected.end(), same)) {
+            mismatch = line;
+        }
+    }
+    CHECK(mismatch == "");
+}
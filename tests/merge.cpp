@@ -0,0 +1,186 @@
+#include "doctest.h"
+#include "merge.h"
+#include "snapshot.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    using lines = std::vector<std::string_view>;
+
+    /// Lines of a merge result, for comparing against an expected file
+    lines merged(const merge_result& result)
+    {
+        REQUIRE(result.conflicts.empty());
+        return result.lines;
+    }
+
+    /// Scratch directory holding a todo file and the merge state, removed when the test ends
+    struct temp_dir
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                     ("ctodo-merge-test-" + std::to_string(getpid()));
+        temp_dir()
+        {
+            std::filesystem::create_directories(path);
+            setenv("XDG_STATE_HOME", (path / "state").c_str(), 1);
+        }
+        ~temp_dir()
+        {
+            unsetenv("XDG_STATE_HOME");
+            std::filesystem::remove_all(path);
+        }
+    };
+
+    /// Contents of the file at `path`, empty if there is none
+    std::string read_file(const std::filesystem::path& path)
+    {
+        auto snapshot = file_snapshot::open(path);
+        return snapshot == nullptr ? std::string() : std::string(snapshot->text());
+    }
+
+    /// Append `line` to todo.txt `fpath` as `ctodo add` does
+    void add(const std::filesystem::path& fpath, std::string_view line)
+    {
+        auto snapshot = file_snapshot::open(fpath);
+        const auto stamp = snapshot == nullptr ? file_stamp{0, 0, 0} : snapshot->stamp();
+        const auto current = read_file(fpath);
+        REQUIRE(write_todo_file(fpath, stamp, current, {current, line, "\n"}));
+    }
+} // namespace
+
+TEST_CASE("merge3 takes a change made on one side only")
+{
+    const lines base{"(A) call mom", "buy milk", "pay rent"};
+    SUBCASE("edit")
+    {
+        const lines theirs{"(A) call mom", "buy milk and eggs", "pay rent"};
+        CHECK(merged(merge3(base, base, theirs)) == theirs);
+        CHECK(merged(merge3(base, theirs, base)) == theirs);
+    }
+    SUBCASE("completion")
+    {
+        const lines ours{"(A) call mom", "x 2026-10-19 buy milk", "pay rent"};
+        CHECK(merged(merge3(base, ours, base)) == ours);
+    }
+    SUBCASE("deletion")
+    {
+        const lines theirs{"(A) call mom", "pay rent"};
+        CHECK(merged(merge3(base, base, theirs)) == theirs);
+    }
+}
+
+TEST_CASE("merge3 combines changes to different regions")
+{
+    const lines base{"a", "b", "c", "d", "e"};
+    const lines ours{"a", "b2", "c", "d", "e"};
+    const lines theirs{"a", "b", "c", "d", "e2", "f"};
+    CHECK(merged(merge3(base, ours, theirs)) == lines{"a", "b2", "c", "d", "e2", "f"});
+}
+
+TEST_CASE("merge3 keeps tasks both sides add at the same place, ours first")
+{
+    const lines base{"a", "b"};
+    const lines ours{"a", "b", "ours"};
+    const lines theirs{"a", "b", "theirs"};
+    CHECK(merged(merge3(base, ours, theirs)) == lines{"a", "b", "ours", "theirs"});
+}
+
+TEST_CASE("merge3 takes a change made the same way on both sides once")
+{
+    const lines base{"a", "b", "c"};
+    const lines both{"a", "x 2026-10-19 b", "c"};
+    CHECK(merged(merge3(base, both, both)) == both);
+}
+
+TEST_CASE("merge3 reports a region changed differently on both sides")
+{
+    const lines base{"a", "b", "c"};
+    const lines ours{"a", "b2", "c"};
+    const lines theirs{"a", "b3", "c"};
+    const auto result = merge3(base, ours, theirs);
+    REQUIRE(result.conflicts.size() == 1);
+    const auto& conflict = result.conflicts[0];
+    CHECK(conflict.base_line == 1);
+    CHECK(conflict.base == lines{"b"});
+    CHECK(conflict.ours == lines{"b2"});
+    CHECK(conflict.theirs == lines{"b3"});
+}
+
+TEST_CASE("merge2 reports every region where the sides differ")
+{
+    SUBCASE("identical")
+    {
+        const lines both{"a", "b"};
+        CHECK(merged(merge2(both, both)) == both);
+    }
+    SUBCASE("edit")
+    {
+        const auto result = merge2({"a", "b", "c"}, {"a", "b2", "c"});
+        REQUIRE(result.conflicts.size() == 1);
+        CHECK(result.conflicts[0].base_line == 1);
+        CHECK(result.conflicts[0].ours == lines{"b"});
+        CHECK(result.conflicts[0].theirs == lines{"b2"});
+    }
+    SUBCASE("completion")
+    {
+        const auto result = merge2({"x 2026-10-19 a", "b"}, {"a", "b"});
+        REQUIRE(result.conflicts.size() == 1);
+        CHECK(result.conflicts[0].ours == lines{"x 2026-10-19 a"});
+        CHECK(result.conflicts[0].theirs == lines{"a"});
+    }
+    SUBCASE("insertion at the end")
+    {
+        const auto result = merge2({"a"}, {"a", "b"});
+        REQUIRE(result.conflicts.size() == 1);
+        CHECK(result.conflicts[0].base_line == 1);
+        CHECK(result.conflicts[0].ours.empty());
+        CHECK(result.conflicts[0].theirs == lines{"b"});
+    }
+}
+
+TEST_CASE("merge3 keeps a line both sides insert once")
+{
+    const lines base{"a"};
+    const lines ours{"a", "shared", "ours"};
+    const lines theirs{"a", "shared", "theirs"};
+    CHECK(merged(merge3(base, ours, theirs)) == lines{"a", "shared", "ours", "theirs"});
+}
+
+TEST_CASE("local writes after a copy diverged do not become the merge base")
+{
+    temp_dir dir;
+    const auto fpath = dir.path / "todo.txt";
+    add(fpath, "shared task");
+    const auto copy = dir.path / "todo (B's conflicted copy 2026-10-19).txt";
+    std::ofstream(copy) << "shared task\ntask from B\n";
+    add(fpath, "task from A");
+
+    const auto base = read_file(merge_base_path(fpath));
+    const auto ours = read_file(fpath), theirs = read_file(copy);
+    CHECK(base != ours);
+    const auto result =
+        merge3(split_all_lines(base), split_all_lines(ours), split_all_lines(theirs));
+    CHECK(merged(result) == lines{"shared task", "task from A", "task from B"});
+}
+
+TEST_CASE("a version synced from elsewhere becomes the merge base; a merge result too")
+{
+    temp_dir dir;
+    const auto fpath = dir.path / "todo.txt";
+    add(fpath, "a");
+    std::ofstream(fpath) << "a\nsynced\n"; // rewritten behind ctodo's back
+    add(fpath, "b");
+    CHECK(read_file(merge_base_path(fpath)) == "a\nsynced\n");
+    add(fpath, "c");
+    CHECK(read_file(merge_base_path(fpath)) == "a\nsynced\n");
+
+    REQUIRE(write_merged_file(fpath, "a\nsynced\nb\nc\nd\n"));
+    CHECK(read_file(merge_base_path(fpath)) == "a\nsynced\nb\nc\nd\n");
+    add(fpath, "e");
+    CHECK(read_file(merge_base_path(fpath)) == "a\nsynced\nb\nc\nd\n");
+}
@@ -0,0 +1,165 @@
+#include "doctest.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    /// Scratch directory removed when the test ends
+    struct temp_dir
+    {
+        std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                     ("ctodo-test-" + std::to_string(getpid()));
+        temp_dir() { std::filesystem::create_directories(path); }
+        ~temp_dir() { std::filesystem::remove_all(path); }
+    };
+
+    /// Check a stress-test file: a header holding the number of task lines, then
+    /// that many complete lines
+    bool well_formed(std::string_view text, size_t& count)
+    {
+        if (text.empty() || text.back() != '\n') return false;
+        const size_t header = text.find('\n');
+        if (header == 0 || !std::all_of(text.begin(), text.begin() + header,
+                                        [](char c) { return c >= '0' && c <= '9'; })) {
+            return false;
+        }
+        count = std::stoul(std::string(text.substr(0, header)));
+        const auto lines = static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+        return lines == count + 1;
+    }
+} // namespace
+
+TEST_CASE("concurrent writers lose no updates and readers never see a torn file")
+{
+    constexpr int writers = 8, readers = 8, updates = 100;
+    temp_dir dir;
+    const auto fpath = dir.path / "todo.txt";
+    REQUIRE(write_file_atomic(fpath, {"0\n"}));
+
+    std::atomic<int> writing{writers};
+    std::atomic<size_t> failed_writes{0}, torn{0}, regressed{0}, reads{0};
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            for (int u = 0; u < updates; ++u) {
+                // read-modify-write of the whole file, as every ctodo writer does
+                file_lock lock(fpath);
+                auto snapshot = file_snapshot::open(fpath);
+                size_t count;
+                if (!lock.locked() || snapshot == nullptr ||
+                    !well_formed(snapshot->text(), count)) {
+                    ++failed_writes;
+                    continue;
+                }
+                std::string text(snapshot->text());
+                text.replace(0, text.find('\n'), std::to_string(count + 1));
+                text += "writer " + std::to_string(w) + " update " + std::to_string(u) + '\n';
+                if (!write_file_atomic(fpath, {text})) ++failed_writes;
+            }
+            --writing;
+        });
+    }
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&] {
+            size_t last = 0;
+            do {
+                auto snapshot = file_snapshot::open(fpath);
+                size_t count;
+                if (snapshot == nullptr || !well_formed(snapshot->text(), count) ||
+                    !snapshot->intact()) {
+                    ++torn;
+                } else if (count < last) {
+                    ++regressed;
+                } else {
+                    last = count;
+                }
+                ++reads;
+            } while (writing > 0);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    CHECK(failed_writes == 0);
+    CHECK(torn == 0);
+    CHECK(regressed == 0);
+    CHECK(reads > 0);
+
+    auto snapshot = file_snapshot::open(fpath);
+    REQUIRE(snapshot != nullptr);
+    size_t count;
+    REQUIRE(well_formed(snapshot->text(), count));
+    CHECK(count == writers * updates);
+    std::set<std::string> lines;
+    std::string_view text = snapshot->text();
+    text.remove_prefix(text.find('\n') + 1);
+    while (!text.empty()) {
+        const size_t nl = text.find('\n');
+        lines.emplace(text.substr(0, nl));
+        text.remove_prefix(nl + 1);
+    }
+    CHECK(lines.size() == count); // each update exactly once
+}
+
+TEST_CASE("a snapshot notices its file being rewritten in place")
+{
+    temp_dir dir;
+    const auto fpath = dir.path / "todo.txt";
+    REQUIRE(write_file_atomic(fpath, {"(A) first\n"}));
+    auto snapshot = file_snapshot::open(fpath);
+    REQUIRE(snapshot != nullptr);
+    CHECK(snapshot->text() == "(A) first\n");
+    CHECK(snapshot->intact());
+
+    // replacing by rename leaves the snapshot's inode alone
+    REQUIRE(write_file_atomic(fpath, {"(A) second\n"}));
+    CHECK(snapshot->intact());
+    CHECK(snapshot->text() == "(A) first\n");
+
+    auto current = file_snapshot::open(fpath);
+    REQUIRE(current != nullptr);
+    std::ofstream(fpath, std::ios::app) << "(B) appended in place\n";
+    CHECK_FALSE(current->intact());
+}
+
+TEST_CASE("reading a snapshot of a file truncated in place fails instead of faulting")
+{
+    temp_dir dir;
+    const auto fpath = dir.path / "todo.txt";
+    REQUIRE(write_file_atomic(fpath, {"(A) first\n(B) second\n"}));
+    auto snapshot = file_snapshot::open(fpath);
+    REQUIRE(snapshot != nullptr);
+    std::string text(snapshot->stamp().size, '\0');
+    CHECK(snapshot->read(text.data()));
+    CHECK(text == "(A) first\n(B) second\n");
+
+    std::filesystem::resize_file(fpath, 4);
+    CHECK_FALSE(snapshot->read(text.data()));
+    CHECK_FALSE(snapshot->intact());
+}
+
+TEST_CASE("replacing a file keeps its permissions and symlink")
+{
+    temp_dir dir;
+    const auto target = dir.path / "todo.txt";
+    const auto link = dir.path / "linked.txt";
+    REQUIRE(write_file_atomic(target, {"(A) first\n"}));
+    std::filesystem::permissions(target, std::filesystem::perms::owner_read |
+                                             std::filesystem::perms::owner_write);
+    std::filesystem::create_symlink("todo.txt", link);
+
+    REQUIRE(write_file_atomic(link, {"(A) second\n"}));
+    CHECK(std::filesystem::is_symlink(link));
+    CHECK(std::filesystem::status(target).permissions() ==
+          (std::filesystem::perms::owner_read | std::filesystem::perms::owner_write));
+    auto snapshot = file_snapshot::open(target);
+    REQUIRE(snapshot != nullptr);
+    CHECK(snapshot->text() == "(A) second\n");
+}
@@ -0,0 +1,17 @@
+#include "doctest.h"
+#include "task_id.h"
+#include <string_view>
+
+TEST_CASE("task numbers count blank lines, as todo.sh does")
+{
+    // "first\n\nthird\n": the blank second line keeps its number
+    const std::pmr::vector<std::string_view> lines{"first", "third"};
+    const std::pmr::vector<uint32_t> numbers{1, 3};
+    const task_ids ids(lines);
+    CHECK(ids.resolve("1", numbers) == 0);
+    CHECK(ids.resolve("2", numbers) == task_ids::npos);
+    CHECK(ids.resolve("3", numbers) == 1);
+    CHECK(ids.resolve("4", numbers) == task_ids::npos);
+    CHECK(ids.resolve("0", numbers) == task_ids::npos);
+    CHECK(ids.resolve(task_ids::format(ids.id(1)), numbers) == 1);
+}
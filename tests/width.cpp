@@ -0,0 +1,93 @@
+#include "doctest.h"
+#include "width.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    /// Rows of wrapped `line`
+    std::vector<std::string> wrap(std::string_view line, size_t cols, size_t indent)
+    {
+        std::pmr::string out;
+        wrap_line(line, cols, indent, out);
+        std::vector<std::string> rows;
+        size_t start = 0;
+        for (size_t nl; (nl = out.find('\n', start)) != std::string::npos; start = nl + 1) {
+            rows.emplace_back(out.substr(start, nl - start));
+        }
+        rows.emplace_back(out.substr(start));
+        return rows;
+    }
+
+    /// `text` without spaces and line breaks, to check that wrapping loses nothing else
+    std::string visible(std::string_view text)
+    {
+        std::string kept;
+        for (char c : text) {
+            if (c != ' ' && c != '\n') kept.push_back(c);
+        }
+        return kept;
+    }
+} // namespace
+
+TEST_CASE("display width counts wide and zero-width characters and skips escapes")
+{
+    CHECK(display_width("") == 0);
+    CHECK(display_width("(A) call mom") == 12);
+    CHECK(display_width("日本語") == 6);
+    CHECK(display_width("é") == 1); // combining acute
+    CHECK(display_width("\x1b[38;5;196m(A)\x1b[0m x") == 5);
+    CHECK(display_width("\x1b]8;;http://x\x07link\x1b]8;;\x1b\\") == 4);
+}
+
+TEST_CASE("width prefix stops before the character that would not fit")
+{
+    CHECK(width_prefix("abcdef", 3) == 3);
+    CHECK(width_prefix("日本語", 3) == 3); // one wide character, not one and a half
+    CHECK(width_prefix("日本語", 4) == 6);
+    CHECK(width_prefix("ab", 10) == 2);
+    // escapes right after the prefix come with it, so colors are not cut in half
+    CHECK(width_prefix("ab\x1b[0mcd", 2) == 6);
+}
+
+TEST_CASE("a truncated line and its ellipsis fit the terminal width")
+{
+    const std::string_view line = "(A) 2026-10-01 日本語のタスク +project @home";
+    for (size_t cols = 2; cols <= display_width(line); ++cols) {
+        const auto kept = line.substr(0, width_prefix(line, cols - 1));
+        CHECK(display_width(kept) + 1 <= cols);
+        CHECK(display_width(kept) + 2 >= cols); // at most a wide character's worth is lost
+    }
+}
+
+TEST_CASE("wrapped rows never exceed the terminal width")
+{
+    const std::vector<std::string_view> lines{
+        "(B) averyveryveryverylongwordthatcannotfitononerowatall +project",
+        "(A) 2026-10-01 日本語のタスクを書いてみるとどうなるでしょうか @home",
+        "x 2026-10-02 2026-09-30 some words  with  double  spaces and +tags @ctx due:2026-11-01",
+        "(C) \x1b[38;5;154m+colored\x1b[0m words wrap by what they show, not their escape bytes",
+        "plain line of short words that wraps a few times at narrow widths",
+    };
+    for (auto line : lines) {
+        for (size_t cols = 8; cols <= 40; ++cols) {
+            const size_t indent = 4;
+            std::pmr::string out;
+            wrap_line(line, cols, indent, out);
+            for (const auto& row : wrap(line, cols, indent)) {
+                CHECK(display_width(row) <= cols);
+            }
+            CHECK(visible(out) == visible(line));
+        }
+    }
+}
+
+TEST_CASE("wrapping breaks at spaces with a hanging indent")
+{
+    CHECK(wrap("(A) call mom about the trip", 12, 4) ==
+          std::vector<std::string>{"(A) call mom", "    about", "    the trip"});
+    CHECK(wrap("short", 12, 4) == std::vector<std::string>{"short"});
+    // a word longer than a row is broken where it reaches the edge
+    CHECK(wrap("(B) abcdefghijkl", 10, 4) ==
+          std::vector<std::string>{"(B)", "    abcdef", "    ghijkl"});
+}